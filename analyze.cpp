@@ -0,0 +1,399 @@
+#include "autopilot.h"
+#include "ball.h"
+#include "game.h"
+#include "level.h"
+#include "paddle.h"
+#include "random.h"
+#include "simulation.h"
+#include "world.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Plays every level many times over on all cores and reports how long the levels take to clear,
+// how often they are lost and how many hits their blocks take. Every worker plays in a game_world
+// of its own (see world.h); the levels themselves are shared.
+//
+// Run r of level l is seeded with seed + l * runs + r, so the results do not depend on the
+// number of threads or on which thread played which run.
+
+enum analyze_policy {
+    autopilot_policy, // See autopilot.h
+    follow_policy, // Keeps the paddle under the lowest ball, like breakout_headless
+    random_policy // Random moves held for a random number of ticks
+};
+
+struct analyze_options {
+    const char* level_file = nullptr;
+    size_t runs = 200; // Per level
+    size_t threads = 0; // 0 for every core
+    analyze_policy policy = autopilot_policy;
+    uint64_t max_ticks = 0; // Per run; 0 for ten simulated minutes
+    uint64_t seed = 1;
+};
+
+bool parse_options(const int argc, char** argv, analyze_options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            options.level_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            options.runs = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            options.max_ticks = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            set_tick_rate(static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+            ++i;
+            if (std::strcmp(argv[i], "autopilot") == 0) {
+                options.policy = autopilot_policy;
+            } else if (std::strcmp(argv[i], "follow") == 0) {
+                options.policy = follow_policy;
+            } else if (std::strcmp(argv[i], "random") == 0) {
+                options.policy = random_policy;
+            } else {
+                std::fprintf(stderr, "the policies are autopilot, follow and random\n");
+                return false;
+            }
+        } else {
+            std::fprintf(stderr, "usage: %s [--levels FILE] [--runs N] [--threads N] [--policy autopilot|follow|random] [--max-ticks N] [--tick-rate HZ] [--seed N]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.level_file != nullptr && !use_level_file(options.level_file)) {
+        std::fprintf(stderr, "cannot load levels from %s\n", options.level_file);
+        return false;
+    }
+    if (options.runs == 0) {
+        std::fprintf(stderr, "there must be at least one run per level\n");
+        return false;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.max_ticks == 0) {
+        options.max_ticks = static_cast<uint64_t>(600.0f * tick_rate);
+    }
+
+    return true;
+}
+
+// Work stealing over a fixed set of tasks, numbered 0 to count - 1. Every worker starts with a
+// contiguous share and takes from its back; a worker that runs dry steals from the front of the
+// others' shares, so the workers stay busy however unevenly the tasks are priced.
+struct work_queue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+};
+
+struct work_stealing_pool {
+    std::vector<std::unique_ptr<work_queue>> queues;
+};
+
+void init_work_stealing_pool(work_stealing_pool& pool, const size_t workers, const size_t task_count)
+{
+    pool.queues.clear();
+    for (size_t worker = 0; worker < workers; ++worker) {
+        auto queue = std::make_unique<work_queue>();
+        for (size_t task = task_count * worker / workers; task < task_count * (worker + 1) / workers; ++task) {
+            queue->tasks.push_back(task);
+        }
+        pool.queues.push_back(std::move(queue));
+    }
+}
+
+// False once there is nothing left anywhere; no task is ever added, so that is final
+bool take_task(work_stealing_pool& pool, const size_t worker, size_t& task, size_t& steals)
+{
+    {
+        work_queue& own = *pool.queues[worker];
+        const std::lock_guard lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < pool.queues.size(); ++i) {
+        work_queue& victim = *pool.queues[(worker + i) % pool.queues.size()];
+        const std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            ++steals;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum run_outcome : uint8_t {
+    cleared_outcome,
+    lost_outcome,
+    timed_out_outcome
+};
+
+struct run_result {
+    run_outcome outcome = timed_out_outcome;
+    uint64_t ticks = 0;
+};
+
+// Everything one worker found, merged once all workers are done
+struct worker_results {
+    std::vector<std::vector<uint64_t>> cell_hits; // Per level, per cell, summed over the runs
+    uint64_t ticks = 0;
+    size_t runs = 0;
+    size_t steals = 0;
+};
+
+struct random_policy_state {
+    random_generator generator;
+    input_state input;
+    int ticks_left = 0;
+};
+
+input_state follow_lowest_ball(const game_world& world)
+{
+    input_state input;
+    const ball_set& balls = world.balls;
+    size_t lowest = 0;
+    for (size_t i = 1; i < balls.size(); ++i) {
+        if (balls.pos_y[i] > balls.pos_y[lowest]) {
+            lowest = i;
+        }
+    }
+    const float paddle_center = world.paddle_pos.x + paddle_size.x * 0.5f;
+    const float ball_center = balls.empty() ? paddle_center : balls.pos_x[lowest] + ball_size.x * 0.5f;
+    const float paddle_step = paddle_speed * tick_duration;
+    input.move_left = ball_center < paddle_center - paddle_step;
+    input.move_right = ball_center > paddle_center + paddle_step;
+
+    return input;
+}
+
+input_state move_randomly(random_policy_state& state)
+{
+    if (state.ticks_left-- <= 0) {
+        const int direction = random_int(state.generator, -1, 1);
+        state.input.move_left = direction < 0;
+        state.input.move_right = direction > 0;
+        state.ticks_left = random_int(state.generator, 5, 60);
+    }
+
+    return state.input;
+}
+
+// Plays one attempt at a level from its start until it is cleared, lost or out of time
+run_result play_level(game_world& world, const analyze_options& options, const size_t level, const uint64_t seed, std::vector<uint64_t>& cell_hits)
+{
+    seed_world(world, seed);
+    world.state = in_game_state;
+    world.level_index = level;
+    load_level(world, 0);
+    // The tick that clears the level loads the next one before its events are read, so the
+    // width has to be this level's, taken now
+    const size_t columns = world.level.columns;
+
+    autopilot pilot;
+    pilot.level = static_cast<int>(level);
+    random_policy_state wanderer;
+    seed_random(wanderer.generator, ~seed);
+
+    run_result result;
+    for (uint64_t tick = 1; tick <= options.max_ticks; ++tick) {
+        input_state input;
+        switch (options.policy) {
+        case autopilot_policy:
+            input = drive_autopilot(world, pilot);
+            break;
+        case follow_policy:
+            input = follow_lowest_ball(world);
+            break;
+        case random_policy:
+            input = move_randomly(wanderer);
+            break;
+        }
+        simulate_tick(world, input);
+
+        for (const game_event& event : world.events) {
+            switch (event.type) {
+            case level_cell_changed_event:
+            case unbreakable_block_hit_event: {
+                const size_t index = static_cast<size_t>(event.pos.y) * columns + static_cast<size_t>(event.pos.x);
+                if (index < cell_hits.size()) {
+                    ++cell_hits[index];
+                }
+                break;
+            }
+            case level_cleared_event:
+                result = { cleared_outcome, tick };
+                break;
+            case ball_lost_event:
+                result = { lost_outcome, tick };
+                break;
+            default:
+                break;
+            }
+        }
+        if (result.outcome != timed_out_outcome) {
+            return result;
+        }
+    }
+
+    result.ticks = options.max_ticks;
+    return result;
+}
+
+void run_worker(const analyze_options& options, work_stealing_pool& pool, const size_t worker, std::vector<run_result>& results, worker_results& found)
+{
+    const size_t level_count = get_level_count();
+    found.cell_hits.resize(level_count);
+    for (size_t level = 0; level < level_count; ++level) {
+        const level_info source = get_source_level(level);
+        found.cell_hits[level].assign(source.rows * source.columns, 0);
+    }
+
+    game_world world;
+    size_t task = 0;
+    while (take_task(pool, worker, task, found.steals)) {
+        const size_t level = task / options.runs;
+        // Every task writes its own slot, so the results need no lock
+        results[task] = play_level(world, options, level, options.seed + task, found.cell_hits[level]);
+        found.ticks += results[task].ticks;
+        ++found.runs;
+    }
+}
+
+// The value below which a fraction of the sorted values lie, interpolating between neighbours
+double get_percentile(const std::vector<double>& sorted, const double fraction)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double position = fraction * static_cast<double>(sorted.size() - 1);
+    const size_t below = static_cast<size_t>(position);
+    const size_t above = std::min(below + 1, sorted.size() - 1);
+    return sorted[below] + (sorted[above] - sorted[below]) * (position - static_cast<double>(below));
+}
+
+void print_distribution(const char* name, std::vector<double>& values)
+{
+    if (values.empty()) {
+        std::printf("  %-16s -\n", name);
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (const double value : values) {
+        sum += value;
+    }
+    std::printf("  %-16s min %7.2f  p10 %7.2f  p50 %7.2f  p90 %7.2f  max %7.2f  mean %7.2f\n", name,
+        values.front(), get_percentile(values, 0.1), get_percentile(values, 0.5), get_percentile(values, 0.9),
+        values.back(), sum / static_cast<double>(values.size()));
+}
+
+void print_level_report(const analyze_options& options, const size_t level, const run_result* runs, const std::vector<uint64_t>& cell_hits)
+{
+    size_t lost = 0;
+    size_t timed_out = 0;
+    std::vector<double> clear_seconds;
+    for (size_t run = 0; run < options.runs; ++run) {
+        switch (runs[run].outcome) {
+        case cleared_outcome:
+            clear_seconds.push_back(static_cast<double>(runs[run].ticks) * tick_duration);
+            break;
+        case lost_outcome:
+            ++lost;
+            break;
+        case timed_out_outcome:
+            ++timed_out;
+            break;
+        }
+    }
+
+    // Mean hits per run of every cell that starts as a block, unbreakable ones included
+    const level_info source = get_source_level(level);
+    std::vector<double> block_hits;
+    for (size_t i = 0; i < source.rows * source.columns; ++i) {
+        const cell_kind kind = cell_decode_table[static_cast<unsigned char>(source.data[i])].kind;
+        if (cell_properties_table[kind].destructible || kind == unbreakable_cell) {
+            block_hits.push_back(static_cast<double>(cell_hits[i]) / static_cast<double>(options.runs));
+        }
+    }
+
+    const double runs = static_cast<double>(options.runs);
+    std::printf("level %zu: %zu x %zu, %zu blocks, %zu runs, %.1f%% cleared, %.1f%% lost, %.1f%% out of time\n",
+        level + 1, source.rows, source.columns, source.blocks, options.runs,
+        100.0 * static_cast<double>(clear_seconds.size()) / runs, 100.0 * static_cast<double>(lost) / runs,
+        100.0 * static_cast<double>(timed_out) / runs);
+    print_distribution("clear time (s)", clear_seconds);
+    print_distribution("hits per block", block_hits);
+}
+
+int main(const int argc, char** argv)
+{
+    analyze_options options;
+    if (!parse_options(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+
+    const size_t level_count = get_level_count();
+    const size_t task_count = level_count * options.runs;
+    std::vector<run_result> results(task_count);
+    std::vector<worker_results> found(options.threads);
+
+    work_stealing_pool pool;
+    init_work_stealing_pool(pool, options.threads, task_count);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t worker = 0; worker < options.threads; ++worker) {
+        workers.emplace_back(run_worker, std::cref(options), std::ref(pool), worker, std::ref(results), std::ref(found[worker]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    uint64_t ticks = 0;
+    size_t steals = 0;
+    size_t busiest = 0;
+    size_t idlest = SIZE_MAX;
+    for (const worker_results& worker : found) {
+        ticks += worker.ticks;
+        steals += worker.steals;
+        busiest = std::max(busiest, worker.runs);
+        idlest = std::min(idlest, worker.runs);
+    }
+
+    const char* policy_names[] = { "autopilot", "follow", "random" };
+    std::printf("runs:             %zu per level, %zu in all, %s policy, seed %llu\n", options.runs, task_count,
+        policy_names[options.policy], static_cast<unsigned long long>(options.seed));
+    std::printf("threads:          %zu, %zu to %zu runs each, %zu stolen\n", options.threads, idlest, busiest, steals);
+    std::printf("elapsed:          %.3f s\n", elapsed.count());
+    std::printf("ticks per second: %.0f\n", static_cast<double>(ticks) / elapsed.count());
+
+    for (size_t level = 0; level < level_count; ++level) {
+        std::vector<uint64_t> cell_hits = std::move(found[0].cell_hits[level]);
+        for (size_t worker = 1; worker < found.size(); ++worker) {
+            for (size_t i = 0; i < cell_hits.size(); ++i) {
+                cell_hits[i] += found[worker].cell_hits[level][i];
+            }
+        }
+        print_level_report(options, level, &results[level * options.runs], cell_hits);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+#include "asset_archive.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+archived_asset archive_image(const char* name, const Image& image)
+{
+    archived_asset result;
+    result.name = name;
+    result.kind = image_asset;
+    result.params[0] = static_cast<uint32_t>(image.width);
+    result.params[1] = static_cast<uint32_t>(image.height);
+    result.params[2] = static_cast<uint32_t>(image.format);
+
+    // Only the base level, the game never uses mipmaps
+    const auto* pixels = static_cast<const unsigned char*>(image.data);
+    result.data.assign(pixels, pixels + GetPixelDataSize(image.width, image.height, image.format));
+
+    return result;
+}
+
+archived_asset archive_region(const char* name, const Rectangle region)
+{
+    archived_asset result;
+    result.name = name;
+    result.kind = region_asset;
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&region);
+    result.data.assign(bytes, bytes + sizeof(region));
+
+    return result;
+}
+
+archived_asset archive_wave(const char* name, const Wave& wave)
+{
+    archived_asset result;
+    result.name = name;
+    result.kind = wave_asset;
+    result.params[0] = wave.frameCount;
+    result.params[1] = wave.sampleRate;
+    result.params[2] = wave.sampleSize;
+    result.params[3] = wave.channels;
+
+    const auto* samples = static_cast<const unsigned char*>(wave.data);
+    result.data.assign(samples, samples + static_cast<size_t>(wave.frameCount) * wave.channels * (wave.sampleSize / 8));
+
+    return result;
+}
+
+archived_asset archive_glyphs(const char* name, const GlyphInfo* glyphs, const Rectangle* recs, const int glyph_count, const int base_size, const int padding)
+{
+    archived_asset result;
+    result.name = name;
+    result.kind = glyphs_asset;
+    result.params[0] = static_cast<uint32_t>(glyph_count);
+    result.params[1] = static_cast<uint32_t>(base_size);
+    result.params[2] = static_cast<uint32_t>(padding);
+
+    result.data.resize(static_cast<size_t>(glyph_count) * sizeof(archived_glyph));
+    auto* archived = reinterpret_cast<archived_glyph*>(result.data.data());
+    for (int i = 0; i < glyph_count; ++i) {
+        archived[i] = { glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX, recs[i] };
+    }
+
+    return result;
+}
+
+archived_asset archive_file(const char* name, const unsigned char* data, const size_t size)
+{
+    archived_asset result;
+    result.name = name;
+    result.kind = file_asset;
+    result.data.assign(data, data + size);
+
+    return result;
+}
+
+size_t align_to_archive(const size_t offset)
+{
+    return (offset + asset_archive_alignment - 1) / asset_archive_alignment * asset_archive_alignment;
+}
+
+bool write_asset_archive(const char* path, const std::vector<archived_asset>& assets)
+{
+    asset_archive_header header = {};
+    std::memcpy(header.magic, asset_archive_magic, sizeof(header.magic));
+    header.version = asset_archive_version;
+    header.entry_count = static_cast<uint32_t>(assets.size());
+
+    std::vector<asset_archive_entry> entries;
+    size_t offset = align_to_archive(sizeof(asset_archive_header) + assets.size() * sizeof(asset_archive_entry));
+    for (const archived_asset& asset : assets) {
+        asset_archive_entry entry = {};
+        if (asset.name.size() >= sizeof(entry.name)) {
+            std::fprintf(stderr, "asset name %s is too long\n", asset.name.c_str());
+            return false;
+        }
+        std::memcpy(entry.name, asset.name.c_str(), asset.name.size());
+        entry.kind = asset.kind;
+        std::memcpy(entry.params, asset.params, sizeof(entry.params));
+        entry.data_offset = offset;
+        entry.data_size = asset.data.size();
+        entries.push_back(entry);
+
+        offset = align_to_archive(offset + asset.data.size());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(asset_archive_entry)));
+    for (size_t i = 0; i < assets.size(); ++i) {
+        const std::vector<char> padding(entries[i].data_offset - static_cast<size_t>(file.tellp()), 0);
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(assets[i].data.data()), static_cast<std::streamsize>(assets[i].data.size()));
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool open_asset_archive(const char* path, asset_archive& archive)
+{
+    if (!map_file(path, archive.file)) {
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const asset_archive_header*>(archive.file.data);
+    if (archive.file.size < sizeof(asset_archive_header)
+        || std::memcmp(header->magic, asset_archive_magic, sizeof(header->magic)) != 0
+        || header->version != asset_archive_version
+        || archive.file.size < sizeof(asset_archive_header) + header->entry_count * sizeof(asset_archive_entry)) {
+        std::fprintf(stderr, "%s is not an asset archive\n", path);
+        close_asset_archive(archive);
+        return false;
+    }
+
+    archive.header = header;
+    archive.entries = reinterpret_cast<const asset_archive_entry*>(archive.file.data + sizeof(asset_archive_header));
+
+    return true;
+}
+
+void close_asset_archive(asset_archive& archive)
+{
+    unmap_file(archive.file);
+    archive.header = nullptr;
+    archive.entries = nullptr;
+}
+
+const asset_archive_entry* find_asset(const asset_archive& archive, const char* name, const asset_kind kind)
+{
+    if (archive.header == nullptr) {
+        return nullptr;
+    }
+
+    // A handful of entries, a linear scan is all it takes
+    for (uint32_t i = 0; i < archive.header->entry_count; ++i) {
+        const asset_archive_entry& entry = archive.entries[i];
+        if (entry.kind == kind && std::strncmp(entry.name, name, sizeof(entry.name)) == 0) {
+            if (entry.data_offset > archive.file.size || entry.data_size > archive.file.size - entry.data_offset) {
+                return nullptr;
+            }
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+const void* get_asset_data(const asset_archive& archive, const asset_archive_entry& entry)
+{
+    return archive.file.data + entry.data_offset;
+}
+
+bool is_asset_data(const asset_archive& archive, const void* data)
+{
+    const auto* bytes = static_cast<const std::byte*>(data);
+    return archive.file.data != nullptr && bytes >= archive.file.data && bytes < archive.file.data + archive.file.size;
+}
+
+bool get_archived_image(const asset_archive& archive, const char* name, Image& image)
+{
+    const asset_archive_entry* entry = find_asset(archive, name, image_asset);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    image = {
+        const_cast<void*>(get_asset_data(archive, *entry)),
+        static_cast<int>(entry->params[0]),
+        static_cast<int>(entry->params[1]),
+        1,
+        static_cast<int>(entry->params[2])
+    };
+
+    return true;
+}
+
+bool get_archived_region(const asset_archive& archive, const char* name, Rectangle& region)
+{
+    const asset_archive_entry* entry = find_asset(archive, name, region_asset);
+    if (entry == nullptr || entry->data_size != sizeof(Rectangle)) {
+        return false;
+    }
+
+    std::memcpy(&region, get_asset_data(archive, *entry), sizeof(Rectangle));
+
+    return true;
+}
+
+bool get_archived_wave(const asset_archive& archive, const char* name, Wave& wave)
+{
+    const asset_archive_entry* entry = find_asset(archive, name, wave_asset);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    wave = {
+        entry->params[0],
+        entry->params[1],
+        entry->params[2],
+        entry->params[3],
+        const_cast<void*>(get_asset_data(archive, *entry))
+    };
+
+    return true;
+}
+
+const archived_glyph* get_archived_glyphs(const asset_archive& archive, const char* name, int& glyph_count)
+{
+    const asset_archive_entry* entry = find_asset(archive, name, glyphs_asset);
+    if (entry == nullptr || entry->data_size != entry->params[0] * sizeof(archived_glyph)) {
+        return nullptr;
+    }
+
+    glyph_count = static_cast<int>(entry->params[0]);
+
+    return static_cast<const archived_glyph*>(get_asset_data(archive, *entry));
+}
@@ -0,0 +1,88 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "mapped_file.h"
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pre-decoded assets, used in place through a memory mapping:
+//   asset_archive_header, asset_archive_entry[entry_count], then the payloads,
+//   each starting at a multiple of asset_archive_alignment.
+// Nothing in it needs decoding: images are raw pixels in a raylib PixelFormat, waves are PCM.
+inline constexpr char asset_archive_magic[4] = { 'B', 'K', 'A', 'A' };
+inline constexpr uint32_t asset_archive_version = 1;
+inline constexpr size_t asset_archive_alignment = 64;
+
+enum asset_kind : uint32_t {
+    image_asset, // params: width, height, pixel format
+    region_asset, // A Rectangle inside the atlas image
+    wave_asset, // params: frame count, sample rate, sample size, channels
+    glyphs_asset, // archived_glyph[params[0]]; params: glyph count, base size, padding
+    file_asset // The file as it is on disk, e.g. music that is streamed anyway
+};
+
+struct asset_archive_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+};
+
+struct asset_archive_entry {
+    char name[96];
+    uint32_t kind;
+    uint32_t params[4];
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t data_size;
+};
+
+struct archived_glyph {
+    int32_t value;
+    int32_t offset_x, offset_y;
+    int32_t advance_x;
+    Rectangle rec;
+};
+
+struct asset_archive {
+    mapped_file file;
+    const asset_archive_header* header = nullptr;
+    const asset_archive_entry* entries = nullptr;
+};
+
+// An asset on its way into an archive
+struct archived_asset {
+    std::string name;
+    asset_kind kind = file_asset;
+    uint32_t params[4] = {};
+    std::vector<unsigned char> data;
+};
+
+archived_asset archive_image(const char* name, const Image& image);
+archived_asset archive_region(const char* name, Rectangle region);
+archived_asset archive_wave(const char* name, const Wave& wave);
+archived_asset archive_glyphs(const char* name, const GlyphInfo* glyphs, const Rectangle* recs, int glyph_count, int base_size, int padding);
+archived_asset archive_file(const char* name, const unsigned char* data, size_t size);
+
+bool write_asset_archive(const char* path, const std::vector<archived_asset>& assets);
+
+bool open_asset_archive(const char* path, asset_archive& archive);
+void close_asset_archive(asset_archive& archive);
+
+// nullptr when the archive has no asset with that name and kind
+const asset_archive_entry* find_asset(const asset_archive& archive, const char* name, asset_kind kind);
+const void* get_asset_data(const asset_archive& archive, const asset_archive_entry& entry);
+bool is_asset_data(const asset_archive& archive, const void* data);
+
+// Views into the mapping; nothing is decoded or copied, so never unload them
+bool get_archived_image(const asset_archive& archive, const char* name, Image& image);
+bool get_archived_region(const asset_archive& archive, const char* name, Rectangle& region);
+bool get_archived_wave(const asset_archive& archive, const char* name, Wave& wave);
+const archived_glyph* get_archived_glyphs(const asset_archive& archive, const char* name, int& glyph_count);
+
+#endif // ASSET_ARCHIVE_H
@@ -0,0 +1,58 @@
+#ifndef ASSET_MANIFEST_H
+#define ASSET_MANIFEST_H
+
+#include <cstddef>
+
+// Every file the game loads. The names double as the keys inside the asset archive, so the
+// loose files and the archive are interchangeable.
+
+// Images packed into the texture atlas, in this order
+enum atlas_image : size_t {
+    wall_atlas_image,
+    block_atlas_image,
+    paddle_atlas_image,
+    ball_atlas_image,
+    atlas_image_count
+};
+
+inline constexpr const char* atlas_image_files[atlas_image_count] = {
+    "data/images/wall.png",
+    "data/images/block.png",
+    "data/images/paddle.png",
+    "data/images/ball.png"
+};
+
+// Sprite sheets are strips of equally wide frames, left to right
+inline constexpr size_t ball_frame_count = 8;
+inline constexpr float ball_frame_duration = 0.18f; // Seconds
+
+// The packed atlas image inside the archive
+inline constexpr const char* atlas_asset_name = "atlas";
+
+inline constexpr const char* void_image_file = "data/images/void.png";
+
+inline constexpr const char* menu_font_file = "data/fonts/ARCADECLASSIC.TTF";
+inline constexpr int menu_font_size = 256;
+inline constexpr int menu_font_glyph_count = 95; // ASCII 32..126, the LoadFontEx() default
+inline constexpr int menu_font_padding = 4;
+
+enum sound_asset : size_t {
+    win_sound_asset,
+    lose_sound_asset,
+    pickup_sound_asset,
+    unbreakable_hit_sound_asset,
+    damage_hit_sound_asset,
+    sound_asset_count
+};
+
+inline constexpr const char* sound_files[sound_asset_count] = {
+    "data/sounds/win.wav",
+    "data/sounds/lose.wav",
+    "data/sounds/pickupCoin.wav",
+    "data/sounds/blockhit.wav",
+    "data/sounds/hitHurt.wav"
+};
+
+inline constexpr const char* bg_music_file = "data/music/AdhesiveWombat-NightShade-NO-COPYRIGHT-8-bit-Music.mp3";
+
+#endif // ASSET_MANIFEST_H
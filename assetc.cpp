@@ -0,0 +1,96 @@
+#include "asset_archive.h"
+#include "asset_manifest.h"
+#include "atlas.h"
+
+#include "raylib.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Decodes everything in asset_manifest.h once and writes it to an asset archive. Run it from
+// the project root so the data/ paths resolve. Missing optional files are left out, the game
+// falls back to the loose file for anything the archive does not have.
+int main(const int argc, char** argv)
+{
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s assets.pak\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::vector<archived_asset> assets;
+
+    // The atlas is packed here so the game only has to upload it
+    std::vector<Image> images;
+    std::vector<Rectangle> regions(atlas_image_count);
+    std::vector<Rectangle*> region_pointers;
+    for (size_t i = 0; i < atlas_image_count; ++i) {
+        Image image = LoadImage(atlas_image_files[i]);
+        if (image.data == nullptr) {
+            std::fprintf(stderr, "cannot read %s\n", atlas_image_files[i]);
+            return EXIT_FAILURE;
+        }
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        images.push_back(image);
+        region_pointers.push_back(&regions[i]);
+    }
+    const Image atlas = build_atlas_image(images, region_pointers);
+    assets.push_back(archive_image(atlas_asset_name, atlas));
+    for (size_t i = 0; i < atlas_image_count; ++i) {
+        assets.push_back(archive_region(atlas_image_files[i], regions[i]));
+        UnloadImage(images[i]);
+    }
+    UnloadImage(atlas);
+
+    Image void_image = LoadImage(void_image_file);
+    if (void_image.data != nullptr) {
+        ImageFormat(&void_image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        assets.push_back(archive_image(void_image_file, void_image));
+        UnloadImage(void_image);
+    }
+
+    // The font is rasterized here; both the glyph metrics and the atlas go in under the font's name
+    int font_data_size = 0;
+    unsigned char* font_data = LoadFileData(menu_font_file, &font_data_size);
+    if (font_data == nullptr) {
+        std::fprintf(stderr, "cannot read %s\n", menu_font_file);
+        return EXIT_FAILURE;
+    }
+    GlyphInfo* glyphs = LoadFontData(font_data, font_data_size, menu_font_size, nullptr, menu_font_glyph_count, FONT_DEFAULT);
+    UnloadFileData(font_data);
+    Rectangle* glyph_recs = nullptr;
+    const Image font_atlas = GenImageFontAtlas(glyphs, &glyph_recs, menu_font_glyph_count, menu_font_size, menu_font_padding, 0);
+    assets.push_back(archive_glyphs(menu_font_file, glyphs, glyph_recs, menu_font_glyph_count, menu_font_size, menu_font_padding));
+    assets.push_back(archive_image(menu_font_file, font_atlas));
+    UnloadFontData(glyphs, menu_font_glyph_count);
+    MemFree(glyph_recs);
+    UnloadImage(font_atlas);
+
+    for (const char* sound_file : sound_files) {
+        const Wave wave = LoadWave(sound_file);
+        if (wave.data == nullptr) {
+            std::fprintf(stderr, "cannot read %s\n", sound_file);
+            return EXIT_FAILURE;
+        }
+        assets.push_back(archive_wave(sound_file, wave));
+        UnloadWave(wave);
+    }
+
+    // Music is streamed, decoding it up front would only make it bigger
+    int music_size = 0;
+    unsigned char* music = LoadFileData(bg_music_file, &music_size);
+    if (music != nullptr) {
+        assets.push_back(archive_file(bg_music_file, music, static_cast<size_t>(music_size)));
+        UnloadFileData(music);
+    }
+
+    if (!write_asset_archive(argv[1], assets)) {
+        std::fprintf(stderr, "cannot write %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::printf("%zu assets written to %s\n", assets.size(), argv[1]);
+
+    return EXIT_SUCCESS;
+}
@@ -1,56 +1,429 @@
 #include "assets.h"
 
+#include "asset_archive.h"
+#include "asset_manifest.h"
+#include "atlas.h"
+#include "audio.h"
+#include "profiler.h"
+
 #include "raylib.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iterator>
+#include <vector>
+
+// Low-memory mode rasterizes the font as a signed distance field at this size and scales it
+// in the shader instead
+constexpr int sdf_font_size = 32;
+
+constexpr const char* sdf_font_fragment_shader = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+out vec4 finalColor;
+
+void main()
+{
+    // The distance field is stored in alpha, 0.5 is the glyph outline
+    float distance = texture(texture0, fragTexCoord).a - 0.5;
+    float width = length(vec2(dFdx(distance), dFdy(distance)));
+    float alpha = smoothstep(-width, width, distance);
+    finalColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
+)";
+
+Sound* const sounds[sound_asset_count] = {
+    &win_sound,
+    &lose_sound,
+    &pickup_sound,
+    &unbreakable_hit_sound,
+    &damage_hit_sound
+};
+
+// A font rasterized on the CPU; only the atlas upload is left for the main thread
+struct decoded_font {
+    GlyphInfo* glyphs = nullptr;
+    Rectangle* recs = nullptr;
+    Image atlas {};
+    int base_size = menu_font_size;
+    int padding = menu_font_padding;
+    bool sdf = false;
+};
+
+// Everything the textures need before the upload. With the archive the atlas comes packed
+// already and images stays empty.
+struct decoded_textures {
+    std::vector<Image> images;
+    Image atlas {};
+    Rectangle regions[atlas_image_count] = {};
+    Image void_image {};
+};
+
+struct asset_loading_state {
+    std::future<decoded_textures> textures;
+    std::future<decoded_font> font;
+    std::future<void> sounds;
+
+    bool textures_loaded = false;
+    bool font_loaded = false;
+    bool sounds_loaded = false;
+
+    std::chrono::steady_clock::time_point start_time;
+};
+
+asset_loading_state loading;
+
+// Open while the game runs: images and waves point into it and the music streams from it
+asset_archive archive;
+
+Rectangle* const atlas_regions[atlas_image_count] = { &wall_region, &block_region, &paddle_region, &ball_region };
+
+size_t get_texture_memory(const Texture2D& texture)
+{
+    return static_cast<size_t>(GetPixelDataSize(texture.width, texture.height, texture.format));
+}
+
+// How much to shrink the images in low-memory mode. A cell image is never drawn larger than
+// max_drawn_cell_size, so anything above the next power of two is wasted.
+float get_texture_scale(const int cell_image_height)
+{
+    if (!low_memory_assets || max_drawn_cell_size <= 0.0f || cell_image_height <= 0) {
+        return 1.0f;
+    }
+
+    int texels = 1;
+    while (static_cast<float>(texels) < std::ceil(max_drawn_cell_size)) {
+        texels *= 2;
+    }
+
+    return std::min(1.0f, static_cast<float>(texels) / static_cast<float>(cell_image_height));
+}
+
+void scale_image(Image& image, const float scale)
+{
+    if (scale < 1.0f && image.data != nullptr) {
+        ImageResize(&image, std::max(1, static_cast<int>(std::lround(image.width * scale))), std::max(1, static_cast<int>(std::lround(image.height * scale))));
+    }
+}
+
+// Images that point into the archive belong to the mapping
+void unload_decoded_image(const Image& image)
+{
+    if (!is_asset_data(archive, image.data)) {
+        UnloadImage(image);
+    }
+}
+
+bool use_asset_archive(const char* path)
+{
+    close_asset_archive(archive);
+    return open_asset_archive(path, archive);
+}
+
+void use_loose_assets()
+{
+    close_asset_archive(archive);
+}
+
+decoded_font decode_font()
+{
+    PROFILE_ZONE("decode_font");
+
+    decoded_font result;
+
+    if (low_memory_assets) {
+        result.base_size = sdf_font_size;
+        result.padding = 0;
+        result.sdf = true;
+    }
+
+    // The archive holds the full size bitmap font
+    int glyph_count = 0;
+    const archived_glyph* glyphs = result.sdf ? nullptr : get_archived_glyphs(archive, menu_font_file, glyph_count);
+    if (glyphs != nullptr && glyph_count == menu_font_glyph_count && get_archived_image(archive, menu_font_file, result.atlas)) {
+        // UnloadFont() frees these, so they are copied into raylib's allocations
+        result.glyphs = static_cast<GlyphInfo*>(MemAlloc(static_cast<unsigned int>(glyph_count * sizeof(GlyphInfo))));
+        result.recs = static_cast<Rectangle*>(MemAlloc(static_cast<unsigned int>(glyph_count * sizeof(Rectangle))));
+        for (int i = 0; i < glyph_count; ++i) {
+            result.glyphs[i] = { glyphs[i].value, glyphs[i].offset_x, glyphs[i].offset_y, glyphs[i].advance_x, {} };
+            result.recs[i] = glyphs[i].rec;
+        }
+        return result;
+    }
+
+    int data_size = 0;
+    unsigned char* data = LoadFileData(menu_font_file, &data_size);
+    if (data == nullptr) {
+        return result;
+    }
+    result.glyphs = LoadFontData(data, data_size, result.base_size, nullptr, menu_font_glyph_count, result.sdf ? FONT_SDF : FONT_DEFAULT);
+    UnloadFileData(data);
+
+    if (result.glyphs != nullptr) {
+        // Skyline packing keeps the SDF atlas small
+        result.atlas = GenImageFontAtlas(result.glyphs, &result.recs, menu_font_glyph_count, result.base_size, result.padding, result.sdf ? 1 : 0);
+    }
+
+    return result;
+}
+
+// Must run on the main thread, it creates the font texture
+Font upload_font(decoded_font& decoded)
+{
+    if (decoded.glyphs == nullptr) {
+        TraceLog(LOG_WARNING, "Cannot load %s, using the default font", menu_font_file);
+        return GetFontDefault();
+    }
+
+    Font font {};
+    font.baseSize = decoded.base_size;
+    font.glyphCount = menu_font_glyph_count;
+    font.glyphPadding = decoded.padding;
+    font.glyphs = decoded.glyphs;
+    font.recs = decoded.recs;
+    font.texture = LoadTextureFromImage(decoded.atlas);
+    unload_decoded_image(decoded.atlas);
+
+    menu_font_sdf = decoded.sdf;
+    if (menu_font_sdf) {
+        SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+        sdf_font_shader = LoadShaderFromMemory(nullptr, sdf_font_fragment_shader);
+    }
+
+    decoded = {};
+    return font;
+}
+
+// Safe to run on a worker thread; loose images are decoded in parallel
+decoded_textures decode_textures()
+{
+    PROFILE_ZONE("decode_textures");
+
+    decoded_textures result;
+
+    if (!get_archived_image(archive, void_image_file, result.void_image)) {
+        result.void_image = LoadImage(void_image_file);
+    }
+
+    bool packed = get_archived_image(archive, atlas_asset_name, result.atlas);
+    for (size_t i = 0; packed && i < atlas_image_count; ++i) {
+        packed = get_archived_region(archive, atlas_image_files[i], result.regions[i]);
+    }
+
+    const float scale = get_texture_scale(packed ? static_cast<int>(result.regions[wall_atlas_image].height) : 0);
+    if (packed && scale == 1.0f) {
+        return result;
+    }
+
+    if (packed) {
+        // Cut the images back out so they are scaled and repacked with whole texel padding
+        for (const Rectangle& region : result.regions) {
+            result.images.push_back(ImageFromImage(result.atlas, region));
+        }
+    } else {
+        std::vector<std::future<Image>> images;
+        for (const char* file_name : atlas_image_files) {
+            images.push_back(std::async(std::launch::async, LoadImage, file_name));
+        }
+        for (auto& image : images) {
+            result.images.push_back(image.get());
+        }
+    }
+    result.atlas = {};
+
+    const float image_scale = packed ? scale : get_texture_scale(result.images[wall_atlas_image].height);
+    for (Image& image : result.images) {
+        scale_image(image, image_scale);
+    }
+    if (!is_asset_data(archive, result.void_image.data)) {
+        scale_image(result.void_image, image_scale);
+    }
+
+    return result;
+}
+
+// Must run on the main thread, it creates the textures
+void upload_textures(decoded_textures& decoded)
+{
+    if (decoded.images.empty()) {
+        atlas_texture = LoadTextureFromImage(decoded.atlas);
+        for (size_t i = 0; i < atlas_image_count; ++i) {
+            *atlas_regions[i] = decoded.regions[i];
+        }
+    } else {
+        atlas_texture = pack_atlas(decoded.images, { std::begin(atlas_regions), std::end(atlas_regions) });
+        for (const Image& image : decoded.images) {
+            UnloadImage(image);
+        }
+    }
+
+    split_sprite_sheet(ball_region, ball_frame_count, ball_frames);
+    ball_animation = { ball_frames, ball_frame_count, ball_frame_duration, true };
+
+    void_texture = LoadTextureFromImage(decoded.void_image);
+    unload_decoded_image(decoded.void_image);
+
+    decoded = {};
+}
+
+// Safe to run on a worker thread, nothing here touches the graphics context
+void init_sounds()
+{
+    PROFILE_ZONE("init_sounds");
+
+    // Decode the loose waves while the audio device starts up
+    std::vector<std::future<Wave>> waves;
+    for (const char* file_name : sound_files) {
+        waves.push_back(std::async(std::launch::async, [file_name] {
+            Wave wave;
+            return get_archived_wave(archive, file_name, wave) ? wave : LoadWave(file_name);
+        }));
+    }
+
+    InitAudioDevice();
+
+    for (size_t i = 0; i < sound_asset_count; ++i) {
+        const Wave wave = waves[i].get();
+        *sounds[i] = LoadSoundFromWave(wave);
+        if (!is_asset_data(archive, wave.data)) {
+            UnloadWave(wave);
+        }
+    }
+
+    // The music streams straight from the mapping
+    const asset_archive_entry* music = find_asset(archive, bg_music_file, file_asset);
+    if (music != nullptr) {
+        const auto* data = static_cast<const unsigned char*>(get_asset_data(archive, *music));
+        bg_music = LoadMusicStreamFromMemory(GetFileExtension(bg_music_file), data, static_cast<int>(music->data_size));
+    } else {
+        bg_music = LoadMusicStream(bg_music_file);
+    }
+    PlayMusicStream(bg_music);
+    SetMusicVolume(bg_music, 0.5f);
+
+    start_audio_playback();
+}
+
 void load_fonts()
 {
-    menu_font = LoadFontEx("data/fonts/ARCADECLASSIC.TTF", 256, nullptr, 0);
+    decoded_font decoded = decode_font();
+    menu_font = upload_font(decoded);
 }
 
 void unload_fonts()
 {
-    UnloadFont(menu_font);
+    // The default font belongs to raylib
+    if (menu_font.texture.id != GetFontDefault().texture.id) {
+        UnloadFont(menu_font);
+    }
+    if (menu_font_sdf) {
+        UnloadShader(sdf_font_shader);
+        menu_font_sdf = false;
+    }
 }
 
 void load_textures()
 {
-    wall_texture = LoadTexture("data/images/wall.png");
-    void_texture = LoadTexture("data/images/void.png");
-    block_texture = LoadTexture("data/images/block.png");
-    paddle_texture = LoadTexture("data/images/paddle.png");
-    ball_sprite = load_sprite("data/images/ball/ball", ".png", 8, true, 10);
+    decoded_textures decoded = decode_textures();
+    upload_textures(decoded);
 }
 
 void unload_textures()
 {
-    UnloadTexture(wall_texture);
+    UnloadTexture(atlas_texture);
     UnloadTexture(void_texture);
-    UnloadTexture(block_texture);
-    UnloadTexture(paddle_texture);
-    unload_sprite(ball_sprite);
 }
 
 void load_sounds()
 {
-    InitAudioDevice();
-    win_sound = LoadSound("data/sounds/win.wav");
-    lose_sound = LoadSound("data/sounds/lose.wav");
-    pickup_sound = LoadSound("data/sounds/pickupCoin.wav");
-    unbreakable_hit_sound = LoadSound("data/sounds/blockhit.wav");
-    damage_hit_sound = LoadSound("data/sounds/hitHurt.wav");
-
-    bg_music = LoadMusicStream("data/music/AdhesiveWombat-NightShade-NO-COPYRIGHT-8-bit-Music.mp3");
-    PlayMusicStream(bg_music);
-    SetMusicVolume(bg_music, 0.5f);
+    init_sounds();
 }
 
 void unload_sounds()
 {
-    UnloadSound(win_sound);
-    UnloadSound(lose_sound);
-    UnloadSound(pickup_sound);
-    UnloadSound(unbreakable_hit_sound);
-    UnloadSound(damage_hit_sound);
+    stop_audio_playback();
+    for (Sound* sound : sounds) {
+        UnloadSound(*sound);
+    }
     UnloadMusicStream(bg_music);
     CloseAudioDevice();
 }
+
+void begin_loading_assets()
+{
+    loading = {};
+    loading.start_time = std::chrono::steady_clock::now();
+
+    // Draw the menu with the built-in font until the real one is ready
+    menu_font = GetFontDefault();
+
+    loading.textures = std::async(std::launch::async, decode_textures);
+    loading.font = std::async(std::launch::async, decode_font);
+    loading.sounds = std::async(std::launch::async, init_sounds);
+}
+
+// With wait set, blocks until the result is there
+template <typename T>
+bool is_ready(const std::future<T>& result, const bool wait)
+{
+    if (wait) {
+        result.wait();
+    }
+    return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool update_asset_loading(const bool wait)
+{
+    PROFILE_ZONE("update_asset_loading");
+
+    if (!loading.font_loaded && loading.font.valid() && is_ready(loading.font, wait)) {
+        decoded_font decoded = loading.font.get();
+        menu_font = upload_font(decoded);
+        loading.font_loaded = true;
+    }
+
+    if (!loading.textures_loaded && loading.textures.valid() && is_ready(loading.textures, wait)) {
+        decoded_textures decoded = loading.textures.get();
+        upload_textures(decoded);
+        loading.textures_loaded = true;
+    }
+
+    if (!loading.sounds_loaded && loading.sounds.valid() && is_ready(loading.sounds, wait)) {
+        loading.sounds.get();
+        loading.sounds_loaded = true;
+    }
+
+    return are_assets_loaded();
+}
+
+bool are_assets_loaded()
+{
+    return loading.font_loaded && loading.textures_loaded && loading.sounds_loaded;
+}
+
+void log_asset_memory()
+{
+    const size_t atlas = get_texture_memory(atlas_texture);
+    const size_t void_image = get_texture_memory(void_texture);
+    const size_t font = get_texture_memory(menu_font.texture);
+    const size_t glyphs = static_cast<size_t>(menu_font.glyphCount) * (sizeof(GlyphInfo) + sizeof(Rectangle));
+    TraceLog(LOG_INFO, "Texture memory: atlas %dx%d %.1f KiB, void %.1f KiB",
+        atlas_texture.width, atlas_texture.height, static_cast<double>(atlas) / 1024.0, static_cast<double>(void_image) / 1024.0);
+    TraceLog(LOG_INFO, "Font memory: %s atlas %dx%d at %d px %.1f KiB, glyph tables %.1f KiB",
+        menu_font_sdf ? "SDF" : "bitmap", menu_font.texture.width, menu_font.texture.height, menu_font.baseSize,
+        static_cast<double>(font) / 1024.0, static_cast<double>(glyphs) / 1024.0);
+    TraceLog(LOG_INFO, "Asset memory total: %.1f KiB", static_cast<double>(atlas + void_image + font + glyphs) / 1024.0);
+}
+
+bool are_sounds_loaded()
+{
+    return loading.sounds_loaded;
+}
+
+double get_asset_loading_time()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - loading.start_time).count();
+}
@@ -3,16 +3,26 @@
 
 #include "raylib.h"
 
+#include "asset_manifest.h"
 #include "sprite.h"
 
 inline Font menu_font;
+// Set when menu_font is a signed distance field, which only looks right through sdf_font_shader
+inline bool menu_font_sdf = false;
+inline Shader sdf_font_shader;
+
+// Wall, block, paddle and the ball frames all live in one atlas texture
+inline Texture2D atlas_texture;
+inline Rectangle wall_region;
+inline Rectangle paddle_region;
+inline Rectangle block_region;
+inline Rectangle ball_region; // The whole ball sprite sheet
 
-inline Texture2D wall_texture;
 inline Texture2D void_texture;
-inline Texture2D paddle_texture;
-inline Texture2D block_texture;
 
-inline sprite ball_sprite;
+// Sprite sheets split into frames; every sprite playing an animation shares its definition
+inline Rectangle ball_frames[ball_frame_count];
+inline sprite_animation ball_animation;
 
 inline Sound win_sound;
 inline Sound lose_sound;
@@ -22,6 +32,17 @@ inline Sound damage_hit_sound;
 
 inline Music bg_music;
 
+// Low-memory mode: the menu font is a small signed distance field and the textures are scaled
+// down to the largest cell size they are drawn at. Both must be set before loading.
+inline bool low_memory_assets = false;
+inline float max_drawn_cell_size = 0.0f; // Pixels; 0 keeps the source resolution
+
+// Loads from a pre-decoded archive written by breakout_assetc instead of the loose files in
+// data/. Anything the archive lacks still comes from its loose file. Keep the archive open
+// until the assets are unloaded.
+bool use_asset_archive(const char* path);
+void use_loose_assets();
+
 void load_fonts();
 void unload_fonts();
 
@@ -31,4 +52,17 @@ void unload_textures();
 void load_sounds();
 void unload_sounds();
 
+// Starts decoding the textures, the font and the sounds on worker threads. Until the font
+// is ready the menu is drawn with the default font.
+void begin_loading_assets();
+// Uploads whatever the workers have finished to the GPU, call it on the main thread once per
+// frame. With wait set it blocks until everything is loaded. Returns are_assets_loaded().
+bool update_asset_loading(bool wait = false);
+bool are_assets_loaded();
+bool are_sounds_loaded();
+// Logs what the textures and the font take up on the GPU and in glyph tables
+void log_asset_memory();
+// Seconds since begin_loading_assets()
+double get_asset_loading_time();
+
 #endif // ASSETS_H
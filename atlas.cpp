@@ -0,0 +1,70 @@
+#include "atlas.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+
+constexpr int atlas_padding = 1;
+constexpr int min_atlas_width = 128;
+
+int next_power_of_two(const int value)
+{
+    int result = 1;
+    while (result < value) {
+        result *= 2;
+    }
+    return result;
+}
+
+Image build_atlas_image(const std::vector<Image>& images, const std::vector<Rectangle*>& regions)
+{
+    assert(images.size() == regions.size());
+
+    int widest = 0;
+    int total_area = 0;
+    for (const Image& image : images) {
+        widest = std::max(widest, image.width + atlas_padding);
+        total_area += (image.width + atlas_padding) * (image.height + atlas_padding);
+    }
+    int width = next_power_of_two(std::max({ widest, min_atlas_width, static_cast<int>(std::sqrt(static_cast<float>(total_area))) }));
+
+    // Shelf packing: tallest images first, left to right, a new shelf when the row is full
+    std::vector<size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return images[a].height > images[b].height; });
+
+    int x = 0;
+    int y = 0;
+    int shelf_height = 0;
+    for (const size_t i : order) {
+        if (x + images[i].width > width) {
+            x = 0;
+            y += shelf_height;
+            shelf_height = 0;
+        }
+        *regions[i] = { static_cast<float>(x), static_cast<float>(y), static_cast<float>(images[i].width), static_cast<float>(images[i].height) };
+        x += images[i].width + atlas_padding;
+        shelf_height = std::max(shelf_height, images[i].height + atlas_padding);
+    }
+    const int height = next_power_of_two(y + shelf_height);
+
+    Image atlas = GenImageColor(width, height, BLANK);
+    for (size_t i = 0; i < images.size(); ++i) {
+        const Rectangle source = { 0.0f, 0.0f, static_cast<float>(images[i].width), static_cast<float>(images[i].height) };
+        ImageDraw(&atlas, images[i], source, *regions[i], WHITE);
+    }
+
+    return atlas;
+}
+
+Texture2D pack_atlas(const std::vector<Image>& images, const std::vector<Rectangle*>& regions)
+{
+    const Image atlas = build_atlas_image(images, regions);
+    const Texture2D texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+
+    return texture;
+}
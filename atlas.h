@@ -0,0 +1,14 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+
+#include <vector>
+
+// Packs the images into a single texture so that everything drawn from it shares one batch.
+// regions[i] receives where images[i] ended up inside the returned texture.
+Texture2D pack_atlas(const std::vector<Image>& images, const std::vector<Rectangle*>& regions);
+// The same packing without the upload, for tools that run without a window
+Image build_atlas_image(const std::vector<Image>& images, const std::vector<Rectangle*>& regions);
+
+#endif // ATLAS_H
@@ -0,0 +1,151 @@
+#include "audio.h"
+
+#include "assets.h"
+#include "profiler.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// How often the music thread tops up the stream. raylib's stream buffers hold a few tens of
+// milliseconds, so this leaves plenty of slack while hardly using the core.
+constexpr auto music_update_interval = std::chrono::milliseconds(5);
+
+Sound* const effect_sounds[sound_effect_count] = {
+    &win_sound,
+    &lose_sound,
+    &pickup_sound,
+    &unbreakable_hit_sound,
+    &damage_hit_sound
+};
+
+// The first voice is the loaded sound itself, the others are aliases of it
+struct voice_pool {
+    Sound voices[max_voices_per_effect] = {};
+    int count = 0;
+    int next = 0; // Taken over when every voice is busy, oldest first
+};
+
+voice_pool voice_pools[sound_effect_count];
+
+uint32_t queued_effects = 0; // One bit per sound_effect
+sound_stats stats;
+
+// raylib's audio functions are called from the music thread and the main thread
+std::mutex audio_mutex;
+std::thread music_thread;
+std::atomic<bool> music_streaming = false;
+
+void stream_music()
+{
+    while (music_streaming.load(std::memory_order_relaxed)) {
+        {
+            PROFILE_ZONE("stream_music");
+            const std::lock_guard lock(audio_mutex);
+            UpdateMusicStream(bg_music);
+        }
+        std::this_thread::sleep_for(music_update_interval);
+    }
+}
+
+void start_audio_playback()
+{
+    for (size_t i = 0; i < sound_effect_count; ++i) {
+        voice_pool& pool = voice_pools[i];
+        pool.voices[0] = *effect_sounds[i];
+        pool.count = std::min(sound_effect_properties_table[i].voices, max_voices_per_effect);
+        for (int voice = 1; voice < pool.count; ++voice) {
+            pool.voices[voice] = LoadSoundAlias(*effect_sounds[i]);
+        }
+        pool.next = 0;
+    }
+
+    music_streaming = true;
+    music_thread = std::thread(stream_music);
+}
+
+void stop_audio_playback()
+{
+    music_streaming = false;
+    if (music_thread.joinable()) {
+        music_thread.join();
+    }
+
+    for (voice_pool& pool : voice_pools) {
+        for (int voice = 1; voice < pool.count; ++voice) {
+            UnloadSoundAlias(pool.voices[voice]);
+        }
+        pool = {};
+    }
+    queued_effects = 0;
+}
+
+void queue_sound_effect(const sound_effect effect)
+{
+    const uint32_t bit = uint32_t { 1 } << effect;
+    if ((queued_effects & bit) != 0) {
+        ++stats.merged;
+    }
+    queued_effects |= bit;
+}
+
+int count_playing_voices()
+{
+    int playing = 0;
+    for (const voice_pool& pool : voice_pools) {
+        for (int voice = 0; voice < pool.count; ++voice) {
+            playing += IsSoundPlaying(pool.voices[voice]) ? 1 : 0;
+        }
+    }
+    return playing;
+}
+
+void play_queued_sound_effects()
+{
+    if (queued_effects == 0) {
+        return;
+    }
+
+    PROFILE_ZONE("play_sound_effects");
+
+    const std::lock_guard lock(audio_mutex);
+
+    int playing = count_playing_voices();
+    for (size_t i = 0; i < sound_effect_count; ++i) {
+        voice_pool& pool = voice_pools[i];
+        if ((queued_effects & (uint32_t { 1 } << i)) == 0 || pool.count == 0) {
+            continue;
+        }
+
+        // Prefer a free voice; with none free the oldest one restarts, which adds no voice
+        int voice = pool.next;
+        for (int tried = 0; tried < pool.count; ++tried) {
+            const int candidate = (pool.next + tried) % pool.count;
+            if (!IsSoundPlaying(pool.voices[candidate])) {
+                voice = candidate;
+                break;
+            }
+        }
+        const bool adds_voice = !IsSoundPlaying(pool.voices[voice]);
+        if (adds_voice && playing >= max_sound_voices && !sound_effect_properties_table[i].essential) {
+            ++stats.dropped;
+            continue;
+        }
+
+        PlaySound(pool.voices[voice]);
+        pool.next = (voice + 1) % pool.count;
+        playing += adds_voice ? 1 : 0;
+        ++stats.played;
+    }
+
+    queued_effects = 0;
+}
+
+sound_stats get_sound_stats()
+{
+    return stats;
+}
@@ -0,0 +1,57 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Sound effects play through small pools of voices, aliases of one loaded sound that share its
+// samples, so rapid hits overlap instead of cutting one another off. Requests are collected
+// during a tick and every effect plays at most once per tick, and all effects together stay
+// under max_sound_voices. The music is streamed by a thread of its own, so a long frame does not
+// starve its buffer.
+enum sound_effect : uint8_t {
+    win_sound_effect,
+    lose_sound_effect,
+    pickup_sound_effect,
+    unbreakable_hit_sound_effect,
+    damage_hit_sound_effect,
+    sound_effect_count
+};
+
+struct sound_effect_properties {
+    int voices; // Copies of the effect that can play at once
+    bool essential; // Plays even when every voice is taken
+};
+
+inline constexpr int max_voices_per_effect = 4;
+
+inline constexpr sound_effect_properties sound_effect_properties_table[sound_effect_count] = {
+    /* win_sound_effect */ { 1, true },
+    /* lose_sound_effect */ { 1, true },
+    /* pickup_sound_effect */ { 2, false },
+    /* unbreakable_hit_sound_effect */ { 4, false },
+    /* damage_hit_sound_effect */ { 4, false },
+};
+
+// Voices playing at once over all effects, essential ones aside
+inline constexpr int max_sound_voices = 8;
+
+struct sound_stats {
+    size_t played = 0;
+    size_t merged = 0; // Requested again within the same tick
+    size_t dropped = 0; // Over the voice cap
+};
+
+// Creates the voices of the loaded sounds and starts streaming the music; init_sounds() calls
+// it once the sounds are in. stop_audio_playback() joins the music thread and frees the voices,
+// before the sounds themselves are unloaded.
+void start_audio_playback();
+void stop_audio_playback();
+
+void queue_sound_effect(sound_effect effect);
+// Plays what was queued since the last call; call once per tick, after its events
+void play_queued_sound_effects();
+
+sound_stats get_sound_stats();
+
+#endif // AUDIO_H
@@ -0,0 +1,205 @@
+#include "autopilot.h"
+
+#include "ball.h"
+#include "game.h"
+#include "level.h"
+#include "paddle.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "world.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+
+// The prediction moves the ball at most this many cells per step, and gives up after max steps
+constexpr float prediction_step = 0.25f;
+constexpr int max_prediction_steps = 16384;
+
+// Horizontal velocities the paddle tries to send the ball back with, cycled per bounce. The
+// paddle deflects the ball by where it lands (see bounce_off_paddle()), and aiming keeps the ball
+// from both speeding up sideways and repeating one path forever.
+constexpr float aim_velocities[] = { 5.0f, -5.0f, 3.0f, -6.5f, 6.5f, -3.0f };
+// How far from the paddle's center the ball may land, in cells
+constexpr float max_aim_offset = 1.2f;
+
+bool overlaps_solid_cell(const game_world& world, const Vector2 pos)
+{
+    // Touching a cell is not overlapping it
+    constexpr float edge_epsilon = 1e-4f;
+
+    const int first_row = static_cast<int>(std::floor(pos.y + edge_epsilon));
+    const int last_row = static_cast<int>(std::floor(pos.y + ball_size.y - edge_epsilon));
+    const int first_column = static_cast<int>(std::floor(pos.x + edge_epsilon));
+    const int last_column = static_cast<int>(std::floor(pos.x + ball_size.x - edge_epsilon));
+    for (int row = first_row; row <= last_row; ++row) {
+        for (int column = first_column; column <= last_column; ++column) {
+            if (is_inside_level(world, row, column) && get_cell_properties(get_level_cell(world, row, column)).solid) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool predict_ball_landing(const game_world& world, Vector2 pos, Vector2 vel, ball_landing& landing)
+{
+    PROFILE_ZONE("predict_ball_landing");
+
+    const float landing_y = world.paddle_pos.y - ball_size.y;
+    const float speed = std::max(std::abs(vel.x), std::abs(vel.y));
+    if (speed == 0.0f) {
+        return false;
+    }
+    const float step = prediction_step / speed;
+
+    // One axis at a time, like a ball that bounces off whichever side it runs into
+    for (int i = 0; i < max_prediction_steps; ++i) {
+        const Vector2 next_x = { pos.x + vel.x * step, pos.y };
+        if (overlaps_solid_cell(world, next_x)) {
+            vel.x = -vel.x;
+        } else {
+            pos.x = next_x.x;
+        }
+
+        const Vector2 next_y = { pos.x, pos.y + vel.y * step };
+        if (vel.y > 0.0f && next_y.y >= landing_y) {
+            landing.x = pos.x + vel.x * ((landing_y - pos.y) / vel.y);
+            landing.vel_x = vel.x;
+            return true;
+        }
+        if (overlaps_solid_cell(world, next_y)) {
+            vel.y = -vel.y;
+        } else {
+            pos.y = next_y.y;
+        }
+
+        if (pos.y > static_cast<float>(world.level.rows)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// The ball that reaches the paddle first is usually the lowest one coming down
+size_t pick_tracked_ball(const ball_set& balls)
+{
+    size_t tracked = SIZE_MAX;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        const bool descending = balls.vel_y[i] > 0.0f;
+        if (tracked == SIZE_MAX) {
+            tracked = i;
+            continue;
+        }
+        const bool tracked_descending = balls.vel_y[tracked] > 0.0f;
+        if (descending != tracked_descending ? descending : balls.pos_y[i] > balls.pos_y[tracked]) {
+            tracked = i;
+        }
+    }
+    return tracked;
+}
+
+input_state drive_autopilot(const game_world& world, autopilot& pilot)
+{
+    input_state input;
+    if (world.state == menu_state) {
+        input.selected_level = pilot.level;
+        return input;
+    }
+    if (world.state == game_over_state || world.state == victory_state) {
+        input.confirm = true;
+        return input;
+    }
+    if (world.state != in_game_state) {
+        return input;
+    }
+
+    const size_t ball = pick_tracked_ball(world.balls);
+    if (ball == SIZE_MAX) {
+        pilot.ball = SIZE_MAX;
+        return input;
+    }
+
+    // Redo the prediction only when the ball is not where last tick's velocity would have taken it
+    constexpr float path_tolerance = 1e-3f;
+    const Vector2 pos = get_ball_pos(world.balls, ball);
+    const Vector2 vel = get_ball_vel(world.balls, ball);
+    const Vector2 expected = { pilot.last_pos.x + pilot.last_vel.x * tick_duration, pilot.last_pos.y + pilot.last_vel.y * tick_duration };
+    const bool path_changed = ball != pilot.ball || vel.x != pilot.last_vel.x || vel.y != pilot.last_vel.y
+        || std::abs(pos.x - expected.x) > path_tolerance || std::abs(pos.y - expected.y) > path_tolerance;
+    if (path_changed) {
+        if (pilot.last_vel.y > 0.0f && vel.y < 0.0f) {
+            ++pilot.aim;
+        }
+        pilot.has_landing = predict_ball_landing(world, pos, vel, pilot.landing);
+    }
+    pilot.ball = ball;
+    pilot.last_pos = pos;
+    pilot.last_vel = vel;
+
+    // Without a landing point, shadow the ball
+    float target = pos.x + ball_size.x * 0.5f;
+    if (pilot.has_landing) {
+        const float aim_velocity = aim_velocities[pilot.aim % std::size(aim_velocities)];
+        const float aim_offset = std::clamp((aim_velocity - pilot.landing.vel_x) / paddle_deflection, -max_aim_offset, max_aim_offset);
+        target = pilot.landing.x + ball_size.x * 0.5f - aim_offset;
+    }
+    const float paddle_center = world.paddle_pos.x + paddle_size.x * 0.5f;
+    const float paddle_step = paddle_speed * tick_duration;
+    input.move_left = target < paddle_center - paddle_step;
+    input.move_right = target > paddle_center + paddle_step;
+
+    return input;
+}
+
+void track_level_runs(level_run_tracker& tracker, const game_world& world, const uint64_t tick)
+{
+    const auto end_attempt = [&tracker, tick](const bool cleared) {
+        if (!tracker.attempting) {
+            return;
+        }
+        if (tracker.levels.size() <= tracker.attempt_level) {
+            tracker.levels.resize(tracker.attempt_level + 1);
+        }
+        level_run_stats& stats = tracker.levels[tracker.attempt_level];
+        ++stats.attempts;
+        if (cleared) {
+            ++stats.clears;
+            stats.clear_ticks += tick - tracker.attempt_start_tick;
+        }
+        tracker.attempting = false;
+    };
+
+    for (const game_event& event : world.events) {
+        switch (event.type) {
+        case level_cleared_event:
+            end_attempt(true);
+            break;
+        case ball_lost_event:
+            end_attempt(false);
+            break;
+        case level_loaded_event:
+            // Also the restart of a lost level; a level left for the menu is not counted
+            tracker.attempting = true;
+            tracker.attempt_level = world.level_index;
+            tracker.attempt_start_tick = tick;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void format_level_run(char* line, const size_t size, const size_t level, const level_run_stats& stats)
+{
+    const double win_rate = stats.attempts > 0 ? 100.0 * static_cast<double>(stats.clears) / static_cast<double>(stats.attempts) : 0.0;
+    if (stats.clears > 0) {
+        const double clear_time = static_cast<double>(stats.clear_ticks) / static_cast<double>(stats.clears) * tick_duration;
+        std::snprintf(line, size, "level %zu: %zu attempts, %.1f%% won, %.1f s mean clear time", level + 1, stats.attempts, win_rate, clear_time);
+    } else {
+        std::snprintf(line, size, "level %zu: %zu attempts, %.1f%% won", level + 1, stats.attempts, win_rate);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include "simulation.h"
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct game_world;
+
+struct ball_landing {
+    float x = 0.0f; // The ball's left edge when its bottom reaches the top of the paddle
+    float vel_x = 0.0f; // Its horizontal velocity then
+};
+
+// A paddle controller for soak tests and demos. It predicts where the ball will come down to the
+// paddle, bouncing off the solid cells of the world's grid, and moves the paddle there. The
+// prediction is only redone when the ball's path changes, so driving a game costs little more
+// than the tick itself. Outside of play it starts the game and restarts it when it ends.
+struct autopilot {
+    int level = 0; // Picked on the menu
+
+    // The ball being tracked and where it was last tick, to notice when its path changes
+    size_t ball = SIZE_MAX;
+    Vector2 last_pos = { 0.0f, 0.0f };
+    Vector2 last_vel = { 0.0f, 0.0f };
+
+    bool has_landing = false;
+    ball_landing landing;
+    size_t aim = 0; // Cycles the direction the ball is sent back in, so it does not repeat one path forever
+};
+
+// The input for the next tick
+input_state drive_autopilot(const game_world& world, autopilot& pilot);
+
+// Where and how the ball will reach the paddle. Bounces off solid cells are followed, the
+// destruction of blocks is not. False if the ball does not come down within the prediction budget.
+bool predict_ball_landing(const game_world& world, Vector2 pos, Vector2 vel, ball_landing& landing);
+
+// Clear time and win rate per level, from the events of each tick
+struct level_run_stats {
+    size_t attempts = 0; // Attempts that ended, cleared or lost
+    size_t clears = 0;
+    uint64_t clear_ticks = 0; // Summed over the clears
+};
+
+struct level_run_tracker {
+    std::vector<level_run_stats> levels;
+    bool attempting = false;
+    size_t attempt_level = 0;
+    uint64_t attempt_start_tick = 0;
+};
+
+// Call after every simulate_tick() with the number of that tick
+void track_level_runs(level_run_tracker& tracker, const game_world& world, uint64_t tick);
+// "level 3: 12 attempts, 75.0% won, 41.2 s mean clear time" for reports
+void format_level_run(char* line, size_t size, size_t level, const level_run_stats& stats);
+
+#endif // AUTOPILOT_H
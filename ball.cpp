@@ -1,75 +1,157 @@
 #include "ball.h"
-#include "assets.h"
 #include "level.h"
 #include "paddle.h"
+#include "pickup.h"
+#include "profiler.h"
+#include "random.h"
+#include "simulation.h"
+#include "world.h"
 
 #include "raylib.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <numbers>
 
-void spawn_ball()
-{
-    for (int column = 0; column < current_level.columns; column++) {
-        for (int row = 0; row < current_level.rows; row++) {
-            if (get_level_cell(row, column) == BALL) {
-                set_level_cell(row, column, VOID);
-                ball_pos = { static_cast<float>(column), static_cast<float>(row) };
-                constexpr float ball_launch_angle_radians = ball_launch_angle_degrees * (std::numbers::pi_v<float> / 180.0f);
-                ball_vel.y = -ball_launch_vel_mag * std::sin(ball_launch_angle_radians);
-                ball_vel.x = (rand() % 2 == 0) ? ball_launch_vel_mag * std::cos(ball_launch_angle_radians) : -ball_launch_vel_mag * std::cos(ball_launch_angle_radians);
-                goto outer_loop_end;
-            }
+size_t add_ball(ball_set& balls, const Vector2 pos, const Vector2 vel)
+{
+    balls.pos_x.push_back(pos.x);
+    balls.pos_y.push_back(pos.y);
+    balls.vel_x.push_back(vel.x);
+    balls.vel_y.push_back(vel.y);
+    balls.prev_pos_x.push_back(pos.x);
+    balls.prev_pos_y.push_back(pos.y);
+
+    return balls.size() - 1;
+}
+
+void launch_ball(ball_set& balls, const Vector2 pos, const float angle_degrees)
+{
+    const float angle_radians = angle_degrees * (std::numbers::pi_v<float> / 180.0f);
+    add_ball(balls, pos, { ball_launch_vel_mag * std::cos(angle_radians), -ball_launch_vel_mag * std::sin(angle_radians) });
+}
+
+// Swap-remove: the last ball takes the place of the removed one
+void remove_ball(ball_set& balls, const size_t index)
+{
+    const size_t last = balls.size() - 1;
+    balls.pos_x[index] = balls.pos_x[last];
+    balls.pos_y[index] = balls.pos_y[last];
+    balls.vel_x[index] = balls.vel_x[last];
+    balls.vel_y[index] = balls.vel_y[last];
+    balls.prev_pos_x[index] = balls.prev_pos_x[last];
+    balls.prev_pos_y[index] = balls.prev_pos_y[last];
+
+    balls.pos_x.pop_back();
+    balls.pos_y.pop_back();
+    balls.vel_x.pop_back();
+    balls.vel_y.pop_back();
+    balls.prev_pos_x.pop_back();
+    balls.prev_pos_y.pop_back();
+}
+
+void hold_balls(ball_set& balls)
+{
+    // Assigning reuses the previous positions' allocations
+    balls.prev_pos_x = balls.pos_x;
+    balls.prev_pos_y = balls.pos_y;
+}
+
+void clear_balls(ball_set& balls)
+{
+    balls.pos_x.clear();
+    balls.pos_y.clear();
+    balls.vel_x.clear();
+    balls.vel_y.clear();
+    balls.prev_pos_x.clear();
+    balls.prev_pos_y.clear();
+}
+
+Vector2 get_ball_pos(const ball_set& balls, const size_t index)
+{
+    return { balls.pos_x[index], balls.pos_y[index] };
+}
+
+Vector2 get_ball_prev_pos(const ball_set& balls, const size_t index)
+{
+    return { balls.prev_pos_x[index], balls.prev_pos_y[index] };
+}
+
+Vector2 get_ball_vel(const ball_set& balls, const size_t index)
+{
+    return { balls.vel_x[index], balls.vel_y[index] };
+}
+
+void launch_random_ball(game_world& world, const Vector2 pos)
+{
+    launch_ball(world.balls, pos, (random_int(world.random, 0, 1) == 0) ? ball_launch_angle_degrees : 180.0f - ball_launch_angle_degrees);
+}
+
+void spawn_ball(game_world& world, const int row, const int column)
+{
+    clear_balls(world.balls);
+
+    if (!is_inside_level(world, row, column)) {
+        return;
+    }
+    set_level_cell(world, row, column, {});
+    launch_random_ball(world, { static_cast<float>(column), static_cast<float>(row) });
+}
+
+// Applies the effect of the ball hitting the cell; the bounce itself is handled by the caller
+void hit_level_cell(game_world& world, const int row, const int column)
+{
+    cell& target = get_level_cell(world, row, column);
+    const cell_properties& properties = get_cell_properties(target);
+    const Vector2 pos = { static_cast<float>(column), static_cast<float>(row) };
+
+    if (properties.reports_hits) {
+        emit_game_event(world, properties.destructible ? multi_hit_block_damaged_event : unbreakable_block_hit_event, pos);
+    }
+    if (!properties.destructible) {
+        return;
+    }
+
+    if (--target.hit_points == 0) {
+        if (properties.drops_powerup) {
+            spawn_pickup(world.pickups, pos, speed_pickup);
         }
+        if (properties.counts_as_block) {
+            --world.level_blocks;
+        }
+        target = {};
+        emit_game_event(world, block_destroyed_event, pos);
     }
-outer_loop_end:;
+    emit_game_event(world, level_cell_changed_event, pos);
 }
 
-// Helper to determine collision response
-enum CollisionType {
-    None,
-    Wall,
-    Breakable,
-    Unbreakable,
-    PowerupBlock,
-    MultiHit
-};
+bool is_solid_level_cell(const game_world& world, const int row, const int column)
+{
+    return is_inside_level(world, row, column) && get_cell_properties(get_level_cell(world, row, column)).solid;
+}
 
-CollisionType get_collision_type(char cell)
+void bounce_off_paddle(game_world& world, const Vector2 pos, Vector2& vel)
 {
-    if (cell == WALL)
-        return Wall;
-    if (cell == BLOCKS)
-        return Breakable;
-    if (cell == UNBREAKABLE_BLOCK)
-        return Unbreakable;
-    if (cell == SPEED_POWERUP_BLOCK)
-        return PowerupBlock;
-    if ((cell >= '1' && cell <= '9') || cell == 'A' || cell == 'B')
-        return MultiHit;
-    return None;
+    emit_game_event(world, paddle_hit_event, pos);
+    vel.y = -std::abs(vel.y);
+    // Add slight deviation based on where the ball hit the paddle
+    const float center_paddle = world.paddle_pos.x + paddle_size.x / 2.0f;
+    const float center_ball = pos.x + ball_size.x / 2.0f;
+    vel.x += (center_ball - center_paddle) * paddle_deflection;
 }
 
-void move_ball()
+void move_ball_discrete(game_world& world, Vector2& pos, Vector2& vel)
 {
     Vector2 next_ball_pos = {
-        ball_pos.x + ball_vel.x,
-        ball_pos.y + ball_vel.y
+        pos.x + vel.x * tick_duration,
+        pos.y + vel.y * tick_duration
     };
 
     // Check collision with level cells
     bool hit_x = false;
     bool hit_y = false;
 
-    // We need to check all 4 corners or just center? The original code checked just next_pos.
-    // Let's stick to the original logic pattern but expanded.
-
-    // Simplification: Check key points or just center? The original `is_colliding_with_level_cell` checks the rect.
-    // We need to know WHICH cell was hit to modify it. `get_colliding_level_cell` does this.
-
-    // But `get_colliding_level_cell` takes a 'look_for' char. We have many types now.
-    // Let's iterate over the area the ball covers and find what it hits.
-
     int min_col = static_cast<int>(next_ball_pos.x);
     int max_col = static_cast<int>(next_ball_pos.x + ball_size.x);
     int min_row = static_cast<int>(next_ball_pos.y);
@@ -79,13 +161,7 @@ void move_ball()
 
     for (int row = min_row; row <= max_row; ++row) {
         for (int column = min_col; column <= max_col; ++column) {
-            if (!is_inside_level(row, column))
-                continue;
-
-            char& cell = get_level_cell(row, column);
-            CollisionType type = get_collision_type(cell);
-
-            if (type == None)
+            if (!is_solid_level_cell(world, row, column))
                 continue;
 
             Rectangle block_rect = { static_cast<float>(column), static_cast<float>(row), 1.0f, 1.0f };
@@ -93,55 +169,30 @@ void move_ball()
 
             if (CheckCollisionRecs(block_rect, ball_rect)) {
 
-                // Determine bounce direction (simple version based on previous pos)
-                // This is a bit tricky with multiple blocks. Let's use the provided simple logic:
-                // Check if we were already overlapping in one axis before moving.
+                // Determine bounce direction based on previous pos:
+                // check if we were already overlapping in one axis before moving.
 
-                bool overlap_x = (ball_pos.x + ball_size.x > column && ball_pos.x < column + 1.0f);
-                bool overlap_y = (ball_pos.y + ball_size.y > row && ball_pos.y < row + 1.0f);
+                bool overlap_x = (pos.x + ball_size.x > column && pos.x < column + 1.0f);
+                bool overlap_y = (pos.y + ball_size.y > row && pos.y < row + 1.0f);
 
                 if (overlap_x && !hit_y) {
-                    ball_vel.y = -ball_vel.y;
+                    vel.y = -vel.y;
                     hit_y = true;
                 } else if (overlap_y && !hit_x) {
-                    ball_vel.x = -ball_vel.x;
+                    vel.x = -vel.x;
                     hit_x = true;
                 } else if (!hit_x && !hit_y) {
-                    ball_vel.x = -ball_vel.x;
-                    ball_vel.y = -ball_vel.y;
+                    vel.x = -vel.x;
+                    vel.y = -vel.y;
                     hit_x = true;
                     hit_y = true;
                 }
 
-                // Handle Block Logic
-                if (type == Breakable) {
-                    cell = VOID;
-                    --current_level_blocks;
-                    // Optional: hit sound? User didn't specify for standard blocks.
-                } else if (type == PowerupBlock) {
-                    cell = VOID;
-                    --current_level_blocks;
-                    active_powerups.push_back({ { static_cast<float>(column), static_cast<float>(row) }, true });
-                } else if (type == MultiHit) {
-                    PlaySound(damage_hit_sound);
-                    if (cell == 'B')
-                        cell = 'A';
-                    else if (cell == 'A')
-                        cell = '9';
-                    else if (cell > '1')
-                        cell--;
-                    else if (cell == '1') {
-                        cell = VOID;
-                        --current_level_blocks;
-                    }
-                } else if (type == Unbreakable) {
-                    PlaySound(unbreakable_hit_sound);
-                }
-                // Unbreakable and Wall just bounce (already handled above)
+                hit_level_cell(world, row, column);
 
+                // Only one collision per tick; fast balls can tunnel, see move_ball_swept()
                 collision_handled = true;
-                break; // Handle one collision per frame to prevent weirdness? Or maybe continue?
-                       // Original code handled one type at a time.
+                break;
             }
         }
         if (collision_handled)
@@ -149,26 +200,276 @@ void move_ball()
     }
 
     // Paddle Collision
-    if (!collision_handled && is_colliding_with_paddle(next_ball_pos, ball_size)) {
-        ball_vel.y = -std::abs(ball_vel.y);
-        // Add some english/x-velocity change based on hit position?
-        // simple-breakout doesn't seem to have it, but it makes game better.
-        // Keeping it simple as per original requirements unless "better physics" was a goal (it is).
-        // Let's add slight deviation.
-        float center_paddle = paddle_pos.x + paddle_size.x / 2.0f;
-        float center_ball = next_ball_pos.x + ball_size.x / 2.0f;
-        ball_vel.x += (center_ball - center_paddle) * 0.05f;
+    if (!collision_handled && is_colliding_with_paddle(world, next_ball_pos, ball_size)) {
+        bounce_off_paddle(world, next_ball_pos, vel);
     }
 
-    ball_pos.x += ball_vel.x;
-    ball_pos.y += ball_vel.y;
+    pos.x += vel.x * tick_duration;
+    pos.y += vel.y * tick_duration;
+}
 
-    // Re-verify bounds/stuck correction (simple)
-    // Removed specific rounding logic from original for generalized loop,
-    // might need to add back if sticking occurs.
+// The earliest thing the ball runs into during the rest of the tick
+struct ball_contact {
+    float time = INFINITY;
+    bool hit_x = false;
+    bool hit_y = false;
+    bool paddle = false;
+    int next_row = 0;
+    int next_column = 0;
+    int cell_count = 0;
+    int rows[max_contact_cells] = {};
+    int columns[max_contact_cells] = {};
+};
+
+void add_contact_cell(ball_contact& contact, const int row, const int column)
+{
+    if (contact.cell_count < max_contact_cells) {
+        contact.rows[contact.cell_count] = row;
+        contact.columns[contact.cell_count] = column;
+        ++contact.cell_count;
+    }
+}
+
+// Walks the grid lines the ball's leading edges cross, in time order (Amanatides-Woo for a box).
+// Only cells the ball is entering are tested, so the first solid one found is the time of impact.
+void find_level_contact(const game_world& world, const Vector2 pos, const Vector2 vel, const float max_time, ball_contact& contact)
+{
+    // Extents are shrunk by this much so that touching a cell is not overlapping it
+    constexpr float edge_epsilon = 1e-4f;
+    // Crossings closer than this in time are treated as a corner
+    constexpr float corner_epsilon = 1e-6f;
+
+    const int step_x = vel.x > 0.0f ? 1 : -1;
+    const int step_y = vel.y > 0.0f ? 1 : -1;
+
+    float next_x_time = INFINITY;
+    float next_y_time = INFINITY;
+    int next_column = 0;
+    int next_row = 0;
+    if (vel.x != 0.0f) {
+        const float boundary = vel.x > 0.0f ? std::ceil(pos.x + ball_size.x) : std::floor(pos.x);
+        next_x_time = (boundary - (vel.x > 0.0f ? pos.x + ball_size.x : pos.x)) / vel.x;
+        next_column = static_cast<int>(boundary) + (vel.x > 0.0f ? 0 : -1);
+    }
+    if (vel.y != 0.0f) {
+        const float boundary = vel.y > 0.0f ? std::ceil(pos.y + ball_size.y) : std::floor(pos.y);
+        next_y_time = (boundary - (vel.y > 0.0f ? pos.y + ball_size.y : pos.y)) / vel.y;
+        next_row = static_cast<int>(boundary) + (vel.y > 0.0f ? 0 : -1);
+    }
+    const float x_time_step = 1.0f / std::abs(vel.x);
+    const float y_time_step = 1.0f / std::abs(vel.y);
+
+    while (true) {
+        const float time = std::min(next_x_time, next_y_time);
+        if (time > max_time) {
+            return;
+        }
+        const bool cross_x = next_x_time <= time + corner_epsilon;
+        const bool cross_y = next_y_time <= time + corner_epsilon;
+
+        // Rows and columns covered at this moment, not counting the ones being entered
+        const Vector2 at = { pos.x + vel.x * time, pos.y + vel.y * time };
+        const int first_row = static_cast<int>(std::floor(at.y + edge_epsilon));
+        const int last_row = static_cast<int>(std::ceil(at.y + ball_size.y - edge_epsilon)) - 1;
+        const int first_column = static_cast<int>(std::floor(at.x + edge_epsilon));
+        const int last_column = static_cast<int>(std::ceil(at.x + ball_size.x - edge_epsilon)) - 1;
+
+        if (cross_x) {
+            for (int row = first_row; row <= last_row; ++row) {
+                if (is_solid_level_cell(world, row, next_column)) {
+                    add_contact_cell(contact, row, next_column);
+                    contact.hit_x = true;
+                }
+            }
+        }
+        if (cross_y) {
+            for (int column = first_column; column <= last_column; ++column) {
+                if (is_solid_level_cell(world, next_row, column)) {
+                    add_contact_cell(contact, next_row, column);
+                    contact.hit_y = true;
+                }
+            }
+        }
+        if (cross_x && cross_y && contact.cell_count == 0 && is_solid_level_cell(world, next_row, next_column)) {
+            // Hit exactly on the corner
+            add_contact_cell(contact, next_row, next_column);
+            contact.hit_x = true;
+            contact.hit_y = true;
+        }
+
+        if (contact.cell_count > 0) {
+            contact.time = time;
+            contact.next_row = next_row;
+            contact.next_column = next_column;
+            return;
+        }
+
+        if (cross_x) {
+            next_column += step_x;
+            next_x_time += x_time_step;
+        }
+        if (cross_y) {
+            next_row += step_y;
+            next_y_time += y_time_step;
+        }
+    }
+}
+
+void find_paddle_contact(const game_world& world, const Vector2 pos, const Vector2 vel, const float max_time, ball_contact& contact)
+{
+    constexpr float paddle_epsilon = 1e-4f;
+
+    // Only the top of the paddle is swept; balls reaching it from the side are handled by the overlap check
+    const float ball_bottom = pos.y + ball_size.y;
+    if (vel.y <= 0.0f || ball_bottom > world.paddle_pos.y + paddle_epsilon) {
+        return;
+    }
+
+    const float time = std::max((world.paddle_pos.y - ball_bottom) / vel.y, 0.0f);
+    if (time > max_time || time >= contact.time) {
+        return;
+    }
+
+    const float x = pos.x + vel.x * time;
+    if (x < world.paddle_pos.x + paddle_size.x && x + ball_size.x > world.paddle_pos.x) {
+        contact = {};
+        contact.time = time;
+        contact.paddle = true;
+    }
+}
+
+void move_ball_swept(game_world& world, Vector2& pos, Vector2& vel)
+{
+    float remaining_time = tick_duration;
+
+    for (int contacts = 0; contacts < max_ball_contacts_per_tick; ++contacts) {
+        ball_contact contact;
+        find_level_contact(world, pos, vel, remaining_time, contact);
+        find_paddle_contact(world, pos, vel, remaining_time, contact);
+
+        if (contact.time > remaining_time) {
+            pos.x += vel.x * remaining_time;
+            pos.y += vel.y * remaining_time;
+            break;
+        }
+
+        pos.x += vel.x * contact.time;
+        pos.y += vel.y * contact.time;
+        remaining_time -= contact.time;
+
+        if (contact.paddle) {
+            pos.y = world.paddle_pos.y - ball_size.y;
+            bounce_off_paddle(world, pos, vel);
+            continue;
+        }
+
+        // Snap onto the grid line to keep rounding errors from overlapping the cell we just hit
+        if (contact.hit_x) {
+            pos.x = vel.x > 0.0f ? static_cast<float>(contact.next_column) - ball_size.x : static_cast<float>(contact.next_column + 1);
+            vel.x = -vel.x;
+        }
+        if (contact.hit_y) {
+            pos.y = vel.y > 0.0f ? static_cast<float>(contact.next_row) - ball_size.y : static_cast<float>(contact.next_row + 1);
+            vel.y = -vel.y;
+        }
+
+        for (int i = 0; i < contact.cell_count; ++i) {
+            hit_level_cell(world, contact.rows[i], contact.columns[i]);
+        }
+    }
+    // If the contact budget runs out the ball simply stops for the rest of the tick
+
+    // The paddle may have moved into the ball from the side
+    if (vel.y > 0.0f && is_colliding_with_paddle(world, pos, ball_size)) {
+        bounce_off_paddle(world, pos, vel);
+    }
+}
+
+// True if nothing solid lies within the box swept between from and to (the ball's top-left corners)
+bool is_ball_path_clear(const game_world& world, const Vector2 from, const Vector2 to)
+{
+    const float min_x = std::min(from.x, to.x);
+    const float min_y = std::min(from.y, to.y);
+    const float max_x = std::max(from.x, to.x) + ball_size.x;
+    const float max_y = std::max(from.y, to.y) + ball_size.y;
+
+    if (CheckCollisionRecs({ min_x, min_y, max_x - min_x, max_y - min_y }, { world.paddle_pos.x, world.paddle_pos.y, paddle_size.x, paddle_size.y })) {
+        return false;
+    }
+
+    for (int row = static_cast<int>(std::floor(min_y)); row <= static_cast<int>(max_y); ++row) {
+        for (int column = static_cast<int>(std::floor(min_x)); column <= static_cast<int>(max_x); ++column) {
+            if (is_solid_level_cell(world, row, column)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void move_ball(game_world& world, const size_t index)
+{
+    PROFILE_ZONE("move_ball");
+
+    ball_set& balls = world.balls;
+    Vector2 pos = get_ball_pos(balls, index);
+    Vector2 vel = get_ball_vel(balls, index);
+
+    if (ball_collision_mode == swept_collision_mode) {
+        move_ball_swept(world, pos, vel);
+    } else {
+        move_ball_discrete(world, pos, vel);
+    }
+
+    balls.pos_x[index] = pos.x;
+    balls.pos_y[index] = pos.y;
+    balls.vel_x[index] = vel.x;
+    balls.vel_y[index] = vel.y;
+}
+
+void move_balls(game_world& world)
+{
+    PROFILE_ZONE("move_balls");
+
+    ball_set& balls = world.balls;
+    // Where each ball starts the step, for the sweep below and for drawing to interpolate from
+    hold_balls(balls);
+
+    const size_t count = balls.size();
+    float* pos_x = balls.pos_x.data();
+    float* pos_y = balls.pos_y.data();
+    const float* vel_x = balls.vel_x.data();
+    const float* vel_y = balls.vel_y.data();
+    const float* prev_pos_x = balls.prev_pos_x.data();
+    const float* prev_pos_y = balls.prev_pos_y.data();
+
+    // Integrate every ball as if in free flight; a straight loop over contiguous arrays the compiler vectorizes
+    const float dt = tick_duration;
+    for (size_t i = 0; i < count; ++i) {
+        pos_x[i] += vel_x[i] * dt;
+        pos_y[i] += vel_y[i] * dt;
+    }
+
+    // Balls that may have touched something are rewound and resolved one by one
+    for (size_t i = 0; i < count; ++i) {
+        const Vector2 from = { prev_pos_x[i], prev_pos_y[i] };
+        if (!is_ball_path_clear(world, from, { pos_x[i], pos_y[i] })) {
+            pos_x[i] = from.x;
+            pos_y[i] = from.y;
+            move_ball(world, i);
+        }
+    }
+
+    // Balls that left the level are gone
+    for (size_t i = balls.size(); i-- > 0;) {
+        if (!is_ball_inside_level(world, i)) {
+            remove_ball(balls, i);
+        }
+    }
 }
 
-bool is_ball_inside_level()
+bool is_ball_inside_level(const game_world& world, const size_t index)
 {
-    return is_inside_level(static_cast<int>(ball_pos.y), static_cast<int>(ball_pos.x));
+    return is_inside_level(world, static_cast<int>(world.balls.pos_y[index]), static_cast<int>(world.balls.pos_x[index]));
 }
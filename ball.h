@@ -3,15 +3,55 @@
 
 #include "raylib.h"
 
-inline constexpr float ball_launch_vel_mag = 0.15f;
+#include <cstddef>
+#include <vector>
+
+struct game_world;
+
+inline constexpr float ball_launch_vel_mag = 9.0f;
 inline constexpr float ball_launch_angle_degrees = 49.6f;
 inline constexpr Vector2 ball_size = { 1.0f, 1.0f };
+inline constexpr float paddle_deflection = 3.0f;
+
+// discrete tests only where the ball ends up each tick and can tunnel through cells at high speed;
+// swept walks every cell along the ball's path and resolves contacts in time order
+enum collision_mode {
+    discrete_collision_mode,
+    swept_collision_mode
+};
+
+inline constexpr int max_ball_contacts_per_tick = 8;
+inline constexpr int max_contact_cells = 8;
+
+inline collision_mode ball_collision_mode = swept_collision_mode;
+
+// All balls in play, stored as structure-of-arrays so the per-tick integration
+// runs over contiguous floats. Ball i is pos_x[i], pos_y[i], vel_x[i], ...
+struct ball_set {
+    std::vector<float> pos_x, pos_y;
+    std::vector<float> vel_x, vel_y;
+    std::vector<float> prev_pos_x, prev_pos_y;
+
+    size_t size() const { return pos_x.size(); }
+    bool empty() const { return pos_x.empty(); }
+};
+
+size_t add_ball(ball_set& balls, Vector2 pos, Vector2 vel);
+void launch_ball(ball_set& balls, Vector2 pos, float angle_degrees);
+void remove_ball(ball_set& balls, size_t index);
+void clear_balls(ball_set& balls);
+// Sets every ball's previous position to where it is now, so that it is drawn without moving
+void hold_balls(ball_set& balls);
 
-inline Vector2 ball_pos;
-inline Vector2 ball_vel;
+Vector2 get_ball_pos(const ball_set& balls, size_t index);
+Vector2 get_ball_prev_pos(const ball_set& balls, size_t index);
+Vector2 get_ball_vel(const ball_set& balls, size_t index);
 
-void spawn_ball();
-void move_ball();
-bool is_ball_inside_level();
+// Launches a ball from pos up and to the left or the right, whichever the world's generator picks
+void launch_random_ball(game_world& world, Vector2 pos);
+void spawn_ball(game_world& world, int row, int column);
+void move_ball(game_world& world, size_t index);
+void move_balls(game_world& world);
+bool is_ball_inside_level(const game_world& world, size_t index);
 
 #endif // BALL_H
@@ -0,0 +1,605 @@
+#include "assets.h"
+#include "autopilot.h"
+#include "ball.h"
+#include "game.h"
+#include "graphics.h"
+#include "level.h"
+#include "level_generator.h"
+#include "paddle.h"
+#include "particles.h"
+#include "random.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "world.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the physics, level loading and rendering paths. Results go to stdout as
+// JSON so runs can be compared between versions; a readable summary goes to stderr.
+// Run it from the project root, the rendering benchmarks need the textures in data/.
+
+using bench_clock = std::chrono::steady_clock;
+
+struct bench_options {
+    const char* filter = nullptr;
+    double min_time = 0.25; // Seconds per sample
+    int samples = 5;
+    bool render = true;
+};
+
+struct bench_result {
+    std::string name;
+    size_t operations = 0; // Per sample
+    double ns_per_operation = 0.0; // Median of the samples
+    double min_ns_per_operation = 0.0;
+    double max_ns_per_operation = 0.0;
+    size_t items_per_operation = 0; // Set for throughput benchmarks, reported as items per ms
+};
+
+bench_options options;
+std::vector<bench_result> results;
+
+// Results are stored here so the measured calls cannot be optimized away
+volatile size_t bench_sink;
+
+double get_items_per_ms(const bench_result& result)
+{
+    return static_cast<double>(result.items_per_operation) / result.ns_per_operation * 1e6;
+}
+
+bool is_selected(const char* name)
+{
+    return options.filter == nullptr || std::strstr(name, options.filter) != nullptr;
+}
+
+// Calls operation(count) with growing counts until one call takes min_time, then takes the
+// samples at that count. operation runs the measured code count times.
+template <typename Operation>
+void run_bench(const char* name, Operation&& operation, const size_t items_per_operation = 0)
+{
+    if (!is_selected(name)) {
+        return;
+    }
+
+    size_t count = 1;
+    for (;;) {
+        const auto start = bench_clock::now();
+        operation(count);
+        const std::chrono::duration<double> elapsed = bench_clock::now() - start;
+        if (elapsed.count() >= options.min_time || count >= (size_t { 1 } << 40)) {
+            break;
+        }
+        const double scale = elapsed.count() > 0.0 ? options.min_time / elapsed.count() * 1.2 : 10.0;
+        count = std::max(count + 1, static_cast<size_t>(static_cast<double>(count) * std::min(scale, 10.0)));
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < options.samples; ++i) {
+        const auto start = bench_clock::now();
+        operation(count);
+        const std::chrono::duration<double, std::nano> elapsed = bench_clock::now() - start;
+        samples.push_back(elapsed.count() / static_cast<double>(count));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    results.push_back({ name, count, samples[samples.size() / 2], samples.front(), samples.back(), items_per_operation });
+    if (items_per_operation != 0) {
+        std::fprintf(stderr, "%-40s %12.1f ns/op  %12.0f items/ms  (%zu ops per sample)\n", name, results.back().ns_per_operation,
+            get_items_per_ms(results.back()), count);
+    } else {
+        std::fprintf(stderr, "%-40s %12.1f ns/op  (%zu ops per sample)\n", name, results.back().ns_per_operation, count);
+    }
+}
+
+// A walled box with the ball and paddle spawns near the bottom. The bottom row is a wall too,
+// so the ball can never be lost however long a benchmark runs. With pillars set, every fourth
+// cell is a pillar, which keeps the ball bouncing.
+std::string make_level_text(const size_t rows, const size_t columns, const bool pillars, const char fill = VOID, const char pillar = WALL)
+{
+    std::string text;
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t column = 0; column < columns; ++column) {
+            const bool border = row == 0 || column == 0 || row == rows - 1 || column == columns - 1;
+            const bool near_spawn = row >= rows - 4;
+            if (border) {
+                text += WALL;
+            } else if (row == rows - 3 && column == columns / 2) {
+                text += BALL;
+            } else if (row == rows - 2 && column == columns / 2 - 1) {
+                text += PADDLE;
+            } else if (near_spawn) {
+                text += VOID;
+            } else if (pillars && row % 4 == 0 && column % 4 == 0) {
+                text += pillar;
+            } else {
+                text += fill;
+            }
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+// The game every benchmark plays in
+game_world world;
+
+void use_single_level(const std::string& text)
+{
+    if (!use_level_text(text.data(), text.size())) {
+        std::fprintf(stderr, "cannot parse a generated level\n");
+        std::exit(EXIT_FAILURE);
+    }
+    world.level_index = 0;
+    load_level(world);
+    world.events.clear();
+}
+
+void step_balls()
+{
+    if (world.balls.size() == 1) {
+        move_ball(world, 0);
+    } else {
+        move_balls(world);
+    }
+}
+
+// A benchmark of a scene that stopped moving would only time the collision checks of a single
+// step, so after the samples the balls have to go on to a new place and, where the scene has
+// blocks, run into them
+void check_balls_moving(const char* name, const ball_set& start, const bool expect_block_hits)
+{
+    const ball_set& balls = world.balls;
+    bool moved = balls.size() != start.size() || balls.pos_x != start.pos_x || balls.pos_y != start.pos_y;
+
+    size_t block_hits = 0;
+    const auto ticks = static_cast<int>(10.0f * tick_rate);
+    for (int tick = 0; tick < ticks; ++tick) {
+        const ball_set before = world.balls;
+        step_balls();
+        moved = moved && (balls.pos_x != before.pos_x || balls.pos_y != before.pos_y);
+        for (const game_event& event : world.events) {
+            block_hits += event.type == unbreakable_block_hit_event || event.type == multi_hit_block_damaged_event || event.type == block_destroyed_event ? 1 : 0;
+        }
+        world.events.clear();
+    }
+
+    if (!moved || (expect_block_hits && block_hits == 0)) {
+        std::fprintf(stderr, "%s: the balls %s\n", name, moved ? "never hit a block" : "stopped moving");
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void bench_move_ball(const char* name, const std::string& level_text, const size_t ball_count, const bool expect_block_hits)
+{
+    if (!is_selected(name)) {
+        return;
+    }
+
+    use_single_level(level_text);
+    const Vector2 pos = get_ball_pos(world.balls, 0);
+    for (size_t i = 1; i < ball_count; ++i) {
+        launch_ball(world.balls, pos, 20.0f + 140.0f * static_cast<float>(i) / static_cast<float>(ball_count));
+    }
+    const ball_set start = world.balls;
+
+    run_bench(name, [](const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            step_balls();
+            world.events.clear();
+        }
+    });
+
+    check_balls_moving(name, start, expect_block_hits);
+}
+
+void bench_physics()
+{
+    // Unbreakable pillars report every hit without ever running out
+    const std::string sparse = make_level_text(64, 64, false);
+    const std::string dense = make_level_text(64, 64, true, VOID, UNBREAKABLE_BLOCK);
+
+    bench_move_ball("move_ball/sparse", sparse, 1, false);
+    bench_move_ball("move_ball/dense", dense, 1, true);
+    bench_move_ball("move_balls/sparse/1000", sparse, 1000, false);
+    bench_move_ball("move_balls/dense/1000", dense, 1000, true);
+
+    // Queries at fixed pseudo-random positions over a grid that is half walls, half blocks
+    use_single_level(make_level_text(64, 64, true, BLOCKS));
+    random_generator generator;
+    seed_random(generator, 1);
+    std::vector<Vector2> positions(4096);
+    for (Vector2& pos : positions) {
+        pos = { static_cast<float>(random_int(generator, 0, 63 * 64)) / 64.0f, static_cast<float>(random_int(generator, 0, 63 * 64)) / 64.0f };
+    }
+
+    run_bench("is_colliding_with_level_cell", [&positions](const size_t count) {
+        size_t hits = 0;
+        for (size_t i = 0; i < count; ++i) {
+            hits += is_colliding_with_level_cell(world, positions[i % positions.size()], ball_size, wall_cell) ? 1 : 0;
+        }
+        bench_sink = hits;
+    });
+
+    run_bench("get_colliding_level_cell", [&positions](const size_t count) {
+        size_t blocks = 0;
+        for (size_t i = 0; i < count; ++i) {
+            blocks += get_colliding_level_cell(world, positions[i % positions.size()], ball_size, block_cell).kind == block_cell ? 1 : 0;
+        }
+        bench_sink = blocks;
+    });
+}
+
+// Whole games on the built-in levels with the autopilot at the paddle, next to the prediction alone
+void bench_autopilot()
+{
+    if (!is_selected("autopilot")) {
+        return;
+    }
+
+    use_builtin_levels();
+    seed_world(world, 1);
+    world.level_index = 0;
+    world.state = menu_state;
+    autopilot pilot;
+
+    run_bench("autopilot/simulate_tick", [&pilot](const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            simulate_tick(world, drive_autopilot(world, pilot));
+        }
+    });
+
+    run_bench("autopilot/predict_ball_landing", [](const size_t count) {
+        size_t landings = 0;
+        for (size_t i = 0; i < count; ++i) {
+            ball_landing landing;
+            const Vector2 pos = world.balls.empty() ? world.paddle_pos : get_ball_pos(world.balls, 0);
+            landings += predict_ball_landing(world, { pos.x, pos.y - 4.0f }, { 5.8f, -6.9f }, landing) ? 1 : 0;
+        }
+        bench_sink = landings;
+    });
+    world.events.clear();
+}
+
+void bench_loading()
+{
+    // The first built-in level, then a 1000x1000 one full of random multi-hit blocks
+    if (is_selected("load_level/small")) {
+        use_builtin_levels();
+        world.level_index = 0;
+        run_bench("load_level/small", [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                load_level(world);
+                world.events.clear();
+            }
+        });
+    }
+
+    if (is_selected("load_level/huge")) {
+        use_single_level(make_level_text(1000, 1000, true, RANDOM_MULTI_HIT_BLOCK));
+        run_bench("load_level/huge", [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                load_level(world);
+                world.events.clear();
+            }
+        });
+    }
+
+    // Restarting from the snapshot against loading again, on the same two levels
+    if (is_selected("restart_level/small")) {
+        use_builtin_levels();
+        world.level_index = 0;
+        load_level(world);
+        run_bench("restart_level/small", [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                restart_level(world);
+                world.events.clear();
+            }
+        });
+    }
+
+    if (is_selected("restart_level/huge")) {
+        use_single_level(make_level_text(1000, 1000, true, RANDOM_MULTI_HIT_BLOCK));
+        run_bench("restart_level/huge", [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                restart_level(world);
+                world.events.clear();
+            }
+        });
+    }
+
+    if (is_selected("rewind_snapshot")) {
+        use_builtin_levels();
+        world.level_index = 0;
+        load_level(world);
+        world.events.clear();
+        rewind_buffer buffer;
+        init_rewind_buffer(buffer);
+        run_bench("rewind_snapshot/push", [&buffer](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                push_rewind_snapshot(buffer, world);
+            }
+            bench_sink = buffer.count;
+        });
+        run_bench("rewind_snapshot/push_pop", [&buffer](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                push_rewind_snapshot(buffer, world);
+                pop_rewind_snapshot(buffer, world);
+            }
+            bench_sink = buffer.count;
+        });
+    }
+
+    if (is_selected("spawn_")) {
+        use_single_level(make_level_text(64, 64, false));
+        const level_info source = get_source_level(0);
+
+        run_bench("spawn_ball", [&source](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                spawn_ball(world, source.ball_row, source.ball_column);
+            }
+        });
+
+        run_bench("spawn_paddle", [&source](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                spawn_paddle(world, source.paddle_row, source.paddle_column);
+            }
+        });
+    }
+}
+
+// Loading and collision queries on every stress scene, to see how they scale with the grid
+void bench_scenes()
+{
+    for (const stress_scene& scene : stress_scenes) {
+        const std::string load_name = std::string("load_level/scene/") + scene.name;
+        const std::string query_name = std::string("get_colliding_level_cell/scene/") + scene.name;
+        if (!is_selected(load_name.c_str()) && !is_selected(query_name.c_str())) {
+            continue;
+        }
+
+        use_generated_level(scene.params);
+        world.level_index = 0;
+        load_level(world);
+        world.events.clear();
+
+        run_bench(load_name.c_str(), [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                load_level(world);
+                world.events.clear();
+            }
+        });
+
+        // Spread over the whole grid, so big grids miss the cache
+        random_generator generator;
+        seed_random(generator, 1);
+        std::vector<Vector2> positions(4096);
+        for (Vector2& pos : positions) {
+            pos = {
+                random_float(generator, 0.0f, static_cast<float>(world.level.columns - 1)),
+                random_float(generator, 0.0f, static_cast<float>(world.level.rows - 1))
+            };
+        }
+        run_bench(query_name.c_str(), [&positions](const size_t count) {
+            size_t blocks = 0;
+            for (size_t i = 0; i < count; ++i) {
+                blocks += get_colliding_level_cell(world, positions[i % positions.size()], ball_size, block_cell).kind == block_cell ? 1 : 0;
+            }
+            bench_sink = blocks;
+        });
+    }
+}
+
+// A screen full of particles bouncing under gravity, none of which expire, at 120 Hz steps
+void fill_particles(particle_system& system, const size_t count)
+{
+    init_particle_system(system, count);
+    system.gravity = 600.0f;
+    system.bounce = true;
+    system.bounds = { 0.0f, 0.0f, 1280.0f, 720.0f };
+    const particle_burst burst = { count, 0.0f, 360.0f, 100.0f, 800.0f, 1e9f, 1e9f, 0.0f, 4.0f, WHITE };
+    emit_particles(system, { 640.0f, 360.0f }, burst);
+}
+
+void bench_particles()
+{
+    for (const size_t count : { size_t { 1000 }, size_t { 100000 } }) {
+        particle_system system;
+        const std::string suffix = "/" + std::to_string(count);
+
+        const std::string kernel_name = std::string("particles/update/") + get_particle_kernel_name() + suffix;
+        if (is_selected(kernel_name.c_str())) {
+            fill_particles(system, count);
+            run_bench(kernel_name.c_str(), [&system](const size_t operations) {
+                for (size_t i = 0; i < operations; ++i) {
+                    update_particles(system, 1.0f / 120.0f);
+                }
+                bench_sink = system.count;
+            }, count);
+        }
+
+        const std::string scalar_name = "particles/update/scalar" + suffix;
+        if (std::strcmp(get_particle_kernel_name(), "scalar") != 0 && is_selected(scalar_name.c_str())) {
+            fill_particles(system, count);
+            run_bench(scalar_name.c_str(), [&system](const size_t operations) {
+                for (size_t i = 0; i < operations; ++i) {
+                    update_particles_scalar(system, 1.0f / 120.0f);
+                }
+                bench_sink = system.count;
+            }, count);
+        }
+    }
+}
+
+// Times the CPU side of rendering: the draw calls recorded and the batches handed to the
+// driver. The GPU runs behind that and is not waited for. With the camera, levels that do not
+// fit on screen are drawn cell by cell, culled to the screen, and there is no layer to bake.
+void bench_rendering(const char* name, const std::string& level_text, const bool camera = false)
+{
+    if (!is_selected(name)) {
+        return;
+    }
+
+    camera_enabled = camera;
+    use_single_level(level_text);
+    derive_graphics_metrics(world);
+    update_camera(world, 1.0f, 0.0f);
+    bake_level_layer(world);
+
+    const RenderTexture2D target = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+
+    if (!camera_active) {
+        const std::string bake_name = std::string(name) + "/bake_level_layer";
+        run_bench(bake_name.c_str(), [](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                bake_level_layer(world);
+            }
+        });
+    }
+
+    const std::string draw_name = std::string(name) + "/draw_level";
+    run_bench(draw_name.c_str(), [&target](const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            BeginTextureMode(target);
+            draw_level(world);
+            submit_draw_commands();
+            EndTextureMode();
+        }
+    });
+
+    // 64 changed cells per frame, re-rendered into the cached layer before the blit
+    const std::string dirty_name = std::string(name) + "/draw_level/64_dirty_cells";
+    if (!camera_active) {
+        run_bench(dirty_name.c_str(), [&target](const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t cell = 0; cell < 64; ++cell) {
+                    mark_level_cell_dirty(1 + cell % (world.level.rows - 2), 1 + (cell * 7 + i) % (world.level.columns - 2));
+                }
+                draw_level(world);
+                BeginTextureMode(target);
+                submit_draw_commands();
+                EndTextureMode();
+            }
+        });
+    }
+
+    UnloadRenderTexture(target);
+    reset_draw_stats();
+}
+
+void bench_particle_rendering(const size_t count)
+{
+    const std::string name = "render/particles/" + std::to_string(count);
+    if (!is_selected(name.c_str())) {
+        return;
+    }
+
+    particle_system system;
+    fill_particles(system, count);
+    const RenderTexture2D target = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+    run_bench(name.c_str(), [&system, &target](const size_t operations) {
+        for (size_t i = 0; i < operations; ++i) {
+            BeginTextureMode(target);
+            draw_particles(system);
+            EndTextureMode();
+        }
+    }, count);
+
+    UnloadRenderTexture(target);
+    reset_draw_stats();
+}
+
+void write_json(FILE* file)
+{
+    std::fprintf(file, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result& result = results[i];
+        std::fprintf(file,
+            "    { \"name\": \"%s\", \"operations\": %zu, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f",
+            result.name.c_str(), result.operations, result.ns_per_operation, result.min_ns_per_operation, result.max_ns_per_operation);
+        if (result.items_per_operation != 0) {
+            std::fprintf(file, ", \"items_per_op\": %zu, \"items_per_ms\": %.1f", result.items_per_operation, get_items_per_ms(result));
+        }
+        std::fprintf(file, " }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ],\n  \"samples\": %d,\n  \"min_time\": %.3f,\n  \"tick_rate\": %.1f\n}\n", options.samples, options.min_time, tick_rate);
+}
+
+int main(const int argc, char** argv)
+{
+    const char* output = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.min_time = std::max(0.001, std::atof(argv[++i]));
+        } else if (std::strcmp(argv[i], "--samples") == 0 && i + 1 < argc) {
+            options.samples = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-render") == 0) {
+            options.render = false;
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--filter TEXT] [--min-time SECONDS] [--samples N] [--no-render] [--output FILE]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    seed_world(world, 1);
+
+    bench_physics();
+    bench_autopilot();
+    bench_loading();
+    bench_scenes();
+    bench_particles();
+
+    if (options.render) {
+        // The window stays hidden, it only provides the GL context
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(1280, 720, "Breakout benchmark");
+        if (IsWindowReady()) {
+            load_fonts();
+            load_textures();
+            bench_rendering("render/40x20", make_level_text(20, 40, false, BLOCKS));
+            bench_rendering("render/200x200", make_level_text(200, 200, true, BLOCKS));
+            for (const stress_scene& scene : stress_scenes) {
+                const std::string scene_name = std::string("render/scene/") + scene.name;
+                const std::string text = generate_level_text(scene.params);
+                // Baking the larger scenes takes seconds per call
+                if (scene.params.rows * scene.params.columns <= 1000 * 1000) {
+                    bench_rendering(scene_name.c_str(), text);
+                }
+                bench_rendering((scene_name + "/camera").c_str(), text, true);
+            }
+            bench_particle_rendering(100000);
+            unload_level_layer();
+            unload_textures();
+            unload_fonts();
+            CloseWindow();
+        } else {
+            std::fprintf(stderr, "no window, skipping the rendering benchmarks\n");
+        }
+    }
+
+    unload_level(world);
+
+    FILE* file = output != nullptr ? std::fopen(output, "w") : stdout;
+    if (file == nullptr) {
+        std::fprintf(stderr, "cannot write %s\n", output);
+        return EXIT_FAILURE;
+    }
+    write_json(file);
+    if (file != stdout) {
+        std::fclose(file);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,180 +1,496 @@
 #include "assets.h"
+#include "audio.h"
+#include "autopilot.h"
 #include "ball.h"
 #include "game.h"
 #include "graphics.h"
+#include "input_log.h"
+#include "latency.h"
 #include "level.h"
+#include "level_generator.h"
 #include "paddle.h"
+#include "profiler.h"
+#include "random.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "world.h"
 
 #include "raylib.h"
 
-void update()
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <random>
+
+// The game being played
+game_world world;
+
+// Holding Backspace steps back through the last ticks. A session being recorded or replayed
+// has to go forward tick by tick, so the buffer is not initialized then and keeps nothing.
+rewind_buffer rewind_history;
+// Set when the history ran out under a held Backspace; the game plays on until it is let go
+bool rewind_exhausted = false;
+
+input_state poll_input()
 {
-    UpdateMusicStream(bg_music);
+    input_state input;
+    input.move_left = IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT);
+    input.move_right = IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT);
+    input.toggle_pause = IsKeyPressed(KEY_P);
+    input.confirm = IsKeyPressed(KEY_ENTER);
+    input.back_to_menu = IsKeyPressed(KEY_M);
 
-    if (IsKeyPressed(KEY_P) && game_state == in_game_state) {
-        game_state = paused_state;
-    } else if (IsKeyPressed(KEY_P) && game_state == paused_state) {
-        game_state = in_game_state;
+    constexpr int level_keys[] = { KEY_ONE, KEY_TWO, KEY_THREE, KEY_FOUR, KEY_FIVE };
+    for (int i = 0; i < static_cast<int>(std::size(level_keys)); ++i) {
+        if (IsKeyPressed(level_keys[i])) {
+            input.selected_level = i;
+            break;
+        }
     }
 
-    if (game_state == paused_state) {
-        return;
-    }
+    return input;
+}
 
-    if (game_state == game_over_state) {
-        if (IsKeyPressed(KEY_ENTER)) {
-            // Restart Level
-            load_level(0); // Reload current level info
-            game_state = in_game_state;
-        } else if (IsKeyPressed(KEY_M)) {
-            // Return to Menu
-            current_level_index = 0;
-            game_state = menu_state;
+void handle_game_events()
+{
+    for (const auto& event : world.events) {
+        switch (event.type) {
+        case level_loaded_event:
+            derive_graphics_metrics(world);
+            bake_level_layer(world);
+            clear_effects();
+            // The snapshots do not carry world.level_start, so stepping back past a load would
+            // leave a restart pointing at the level being left
+            clear_rewind_buffer(rewind_history);
+            break;
+        case level_cleared_event:
+            queue_sound_effect(win_sound_effect);
+            break;
+        case game_completed_event:
+            init_victory_menu();
+            break;
+        case ball_lost_event:
+            queue_sound_effect(lose_sound_effect);
+            break;
+        case powerup_collected_event:
+            queue_sound_effect(pickup_sound_effect);
+            break;
+        case multi_hit_block_damaged_event:
+            queue_sound_effect(damage_hit_sound_effect);
+            break;
+        case unbreakable_block_hit_event:
+            queue_sound_effect(unbreakable_hit_sound_effect);
+            break;
+        case level_cell_changed_event:
+            mark_level_cell_dirty(static_cast<size_t>(event.pos.y), static_cast<size_t>(event.pos.x));
+            break;
+        case block_destroyed_event:
+            emit_block_debris(event.pos);
+            break;
+        case paddle_hit_event:
+            emit_paddle_sparks(event.pos);
+            break;
         }
-        return;
     }
+    play_queued_sound_effects();
+}
 
-    if (game_state == victory_state) {
-        if (IsKeyPressed(KEY_ENTER)) {
-            game_state = menu_state;
-        }
-        return;
+constexpr const char* default_level_file = "data/levels/levels.txt";
+
+constexpr float max_frame_time = 0.25f;
+constexpr float fast_forward_scale = 4.0f;
+
+input_state pending_input;
+float tick_accumulator = 0.0f;
+bool show_debug_overlay = false;
+
+#ifdef BREAKOUT_PROFILER
+constexpr size_t profile_trace_frames = 300;
+bool show_profiler_overlay = false;
+
+void dump_profile_trace()
+{
+    char path[64];
+    std::snprintf(path, sizeof(path), "breakout-trace-%lld.json", static_cast<long long>(std::time(nullptr)));
+    if (write_profile_trace(path, profile_trace_frames)) {
+        TraceLog(LOG_INFO, "Wrote the last %zu frames to %s", profile_trace_frames, path);
+    } else {
+        TraceLog(LOG_WARNING, "Cannot write %s", path);
     }
+}
+#endif
+
+bool recording = false;
+input_recorder recorder;
+
+// While replaying, the ticks take their input from the log instead of the keyboard
+bool replaying = false;
+input_log replay_log;
+size_t replay_tick = 0;
 
-    if (game_state == menu_state) {
-        if (IsKeyPressed(KEY_ENTER)) {
-            game_state = in_game_state;
-            load_level(0); // Start/Reset Level 1
-        } else if (IsKeyPressed(KEY_ONE)) {
-            game_state = in_game_state;
-            current_level_index = 0;
-            load_level(0);
-        } else if (IsKeyPressed(KEY_TWO)) {
-            game_state = in_game_state;
-            current_level_index = 1;
-            load_level(0);
-        } else if (IsKeyPressed(KEY_THREE)) {
-            game_state = in_game_state;
-            current_level_index = 2;
-            load_level(0);
-        } else if (IsKeyPressed(KEY_FOUR)) {
-            game_state = in_game_state;
-            current_level_index = 3;
-            load_level(0);
-        } else if (IsKeyPressed(KEY_FIVE)) {
-            game_state = in_game_state;
-            current_level_index = 4;
-            load_level(0);
+void finish_replay()
+{
+    replaying = false;
+    if (!replay_log.finished) {
+        TraceLog(LOG_INFO, "Replay finished after %zu ticks, unverified as the recording was not finished", replay_tick);
+    } else if (hash_game_state(world) == replay_log.header.final_state_hash) {
+        TraceLog(LOG_INFO, "Replay finished after %zu ticks, the state matches the recording", replay_tick);
+    } else {
+        TraceLog(LOG_WARNING, "Replay finished after %zu ticks, the state differs from the recording", replay_tick);
+    }
+}
+
+// With the autopilot on, it moves the paddle and gets past the menus; pausing stays with the keyboard
+bool autopilot_enabled = false;
+autopilot pilot;
+level_run_tracker autopilot_runs;
+uint64_t tick_count = 0;
+
+void log_autopilot_runs()
+{
+    for (size_t level = 0; level < autopilot_runs.levels.size(); ++level) {
+        if (autopilot_runs.levels[level].attempts > 0) {
+            char line[128];
+            format_level_run(line, sizeof(line), level, autopilot_runs.levels[level]);
+            TraceLog(LOG_INFO, "Autopilot %s", line);
         }
-        return;
     }
+}
 
-    // In Game Logic
-    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
-        move_paddle(-paddle_speed);
+void handle_function_keys()
+{
+    if (IsKeyPressed(KEY_F3)) {
+        show_debug_overlay = !show_debug_overlay;
     }
-    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
-        move_paddle(paddle_speed);
+    if (IsKeyPressed(KEY_F6)) {
+        autopilot_enabled = !autopilot_enabled;
+        // An attempt that was not all autopilot would skew the statistics
+        autopilot_runs.attempting = false;
+        TraceLog(LOG_INFO, "Autopilot %s", autopilot_enabled ? "on" : "off");
     }
-    move_ball();
+#ifdef BREAKOUT_PROFILER
+    if (IsKeyPressed(KEY_F8)) {
+        show_profiler_overlay = !show_profiler_overlay;
+    }
+    if (IsKeyPressed(KEY_F9)) {
+        dump_profile_trace();
+    }
+#endif
+}
 
-    // Update Powerups
-    for (auto& powerup : active_powerups) {
-        if (!powerup.active)
-            continue;
-        powerup.pos.y += 0.05f; // Fall speed
+// Key presses are kept until a tick consumes them, so frames that run no tick do not drop them.
+void latch_input(const input_state& polled)
+{
+    pending_input.move_left = polled.move_left;
+    pending_input.move_right = polled.move_right;
+    pending_input.toggle_pause |= polled.toggle_pause;
+    pending_input.confirm |= polled.confirm;
+    pending_input.back_to_menu |= polled.back_to_menu;
+    if (polled.selected_level >= 0) {
+        pending_input.selected_level = polled.selected_level;
+    }
+}
 
-        // Check collision with paddle
-        if (CheckCollisionRecs(
-                { powerup.pos.x, powerup.pos.y, 1.0f, 1.0f },
-                { paddle_pos.x * cell_size / screen_scale, paddle_pos.y * cell_size / screen_scale, paddle_size.x, paddle_size.y })) {
-            // Note: Coordinate space mismatch might be an issue here.
-            // Let's use logic consistent with move_ball collision.
-            // Actually, simpler: check logical coordinates.
-        }
+void update()
+{
+    PROFILE_ZONE("update");
 
-        // Simpler collision check using logical coordinates
-        Rectangle powerup_rec = { powerup.pos.x, powerup.pos.y, 1.0f, 1.0f };
-        Rectangle paddle_rec = { paddle_pos.x, paddle_pos.y, paddle_size.x, paddle_size.y };
+    // Hold the game on the menu until the textures and sounds it needs are in
+    if (!are_assets_loaded()) {
+        return;
+    }
 
-        if (CheckCollisionRecs(powerup_rec, paddle_rec)) {
-            powerup.active = false;
-            PlaySound(pickup_sound);
-            // TODO: Apply speed boost effect (need to modify paddle speed)
-            // For now just collect it.
+    const input_state polled = poll_input();
+    if (!replaying) {
+        latch_input(polled);
+    }
+
+    // Clamp long frames so a hitch does not turn into a burst of catch-up ticks
+    float frame_time = std::min(GetFrameTime(), max_frame_time);
+    if (IsKeyDown(KEY_TAB)) {
+        frame_time *= fast_forward_scale;
+    }
+
+    tick_accumulator += frame_time;
+    float simulated_time = 0.0f;
+    if (!IsKeyDown(KEY_BACKSPACE)) {
+        rewind_exhausted = false;
+    }
+    const bool rewinding = IsKeyDown(KEY_BACKSPACE) && !rewind_exhausted
+        && (world.state == in_game_state || world.state == game_over_state);
+    bool rewound = false;
+    while (tick_accumulator >= tick_duration) {
+        if (rewinding && !rewind_exhausted) {
+            if (pop_rewind_snapshot(rewind_history, world)) {
+                rewound = true;
+                tick_accumulator -= tick_duration;
+                continue;
+            }
+            rewind_exhausted = true;
         }
 
-        if (powerup.pos.y > current_level.rows) {
-            powerup.active = false;
+        if (replaying) {
+            if (replay_tick == replay_log.ticks.size()) {
+                finish_replay();
+                break;
+            }
+            pending_input = unpack_input(replay_log.ticks[replay_tick++]);
+        } else if (autopilot_enabled) {
+            const bool toggle_pause = pending_input.toggle_pause;
+            pending_input = drive_autopilot(world, pilot);
+            pending_input.toggle_pause = toggle_pause;
+        }
+        if (recording) {
+            record_input(recorder, pending_input);
+        }
+        if (world.state == in_game_state) {
+            push_rewind_snapshot(rewind_history, world);
         }
+        simulate_tick(world, pending_input);
+        handle_game_events();
+        if (autopilot_enabled) {
+            track_level_runs(autopilot_runs, world, tick_count);
+        }
+        ++tick_count;
+
+        pending_input = { pending_input.move_left, pending_input.move_right };
+        tick_accumulator -= tick_duration;
+        simulated_time += tick_duration;
     }
 
-    // Level Transition Logic
-    if (!is_ball_inside_level()) {
-        PlaySound(lose_sound);
-        game_state = game_over_state;
-    } else if (current_level_blocks == 0) {
-        PlaySound(win_sound);
-        load_level(1);
+    if (rewound) {
+        // The grid may be from another level, and the autopilot's prediction is stale
+        derive_graphics_metrics(world);
+        bake_level_layer(world);
+        pilot = {};
+        autopilot_runs.attempting = false;
     }
+
+    advance_sprites(simulated_time);
+    advance_particles(world, simulated_time);
 }
 
-void draw()
+void draw(const float alpha)
 {
-    if (game_state == menu_state) {
+    PROFILE_ZONE("draw");
+
+    if (world.state == menu_state) {
         draw_menu();
-    } else if (game_state == in_game_state || game_state == paused_state || game_state == game_over_state) {
-        draw_level();
-        draw_paddle();
-        draw_ball();
-        draw_ui();
-
-        // Draw Powerups
-        for (const auto& powerup : active_powerups) {
-            if (powerup.active) {
-                // Draw 'S'
-                const float texture_x_pos = shift_to_center.x + powerup.pos.x * cell_size;
-                const float texture_y_pos = shift_to_center.y + powerup.pos.y * cell_size;
-                DrawText("S", texture_x_pos + cell_size / 4, texture_y_pos, cell_size, YELLOW);
-            }
-        }
+    } else if (world.state == in_game_state || world.state == paused_state || world.state == game_over_state) {
+        update_camera(world, alpha, GetFrameTime());
+        draw_level(world);
+        draw_paddle(world, alpha);
+        draw_ball(world, alpha);
+        draw_pickups(world);
+        submit_draw_commands();
+        draw_effects();
+        draw_ui(world);
 
-        if (game_state == paused_state) {
+        if (world.state == paused_state) {
             draw_pause_menu();
-        } else if (game_state == game_over_state) {
+        } else if (world.state == game_over_state) {
             draw_game_over_menu();
         }
-    } else if (game_state == victory_state) {
+    } else if (world.state == victory_state) {
         draw_victory_menu();
     }
 }
 
-int main()
+int main(const int argc, char** argv)
 {
-    SetConfigFlags(FLAG_VSYNC_HINT);
+    bool vsync = true;
+    bool low_latency = false;
+    bool frame_pacing = false;
+    const char* level_file = default_level_file;
+    const char* asset_archive_file = nullptr;
+    const char* record_file = nullptr;
+    const char* replay_file = nullptr;
+    const stress_scene* scene = nullptr;
+    uint64_t seed = std::random_device {}();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            set_tick_rate(static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--collision") == 0 && i + 1 < argc) {
+            ++i;
+            ball_collision_mode = std::strcmp(argv[i], "discrete") == 0 ? discrete_collision_mode : swept_collision_mode;
+        } else if (std::strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            level_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            scene = find_stress_scene(argv[++i]);
+            if (scene == nullptr) {
+                TraceLog(LOG_WARNING, "There is no scene %s", argv[i]);
+            }
+        } else if (std::strcmp(argv[i], "--assets") == 0 && i + 1 < argc) {
+            asset_archive_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--no-vsync") == 0) {
+            vsync = false;
+        } else if (std::strcmp(argv[i], "--low-latency") == 0) {
+            low_latency = true;
+        } else if (std::strcmp(argv[i], "--frame-pacing") == 0) {
+            low_latency = true;
+            frame_pacing = true;
+        } else if (std::strcmp(argv[i], "--low-memory") == 0) {
+            low_memory_assets = true;
+        } else if (std::strcmp(argv[i], "--no-camera") == 0) {
+            camera_enabled = false;
+        } else if (std::strcmp(argv[i], "--autopilot") == 0) {
+            autopilot_enabled = true;
+        }
+    }
+
+    if (vsync) {
+        SetConfigFlags(FLAG_VSYNC_HINT);
+    }
     InitWindow(1280, 720, "Breakout");
-    SetTargetFPS(60);
+    init_effects();
+
+    // Without the level file the built-in levels are used
+    if (scene != nullptr) {
+        use_generated_level(scene->params);
+        TraceLog(LOG_INFO, "Playing the %s scene: %s", scene->name, scene->description);
+    } else if (!use_level_file(level_file)) {
+        TraceLog(LOG_WARNING, "Cannot load levels from %s, using the built-in levels", level_file);
+    }
+
+    // The levels decide how large a cell can get, and so how large the textures need to be
+    if (low_memory_assets) {
+        max_drawn_cell_size = get_max_cell_size();
+    }
+
+    if (asset_archive_file != nullptr && !use_asset_archive(asset_archive_file)) {
+        TraceLog(LOG_WARNING, "Cannot open %s, loading the loose asset files", asset_archive_file);
+    }
+
+    // Decoding runs on worker threads while the menu is already on screen
+    begin_loading_assets();
+
+    // Everything random comes from the seed, so seed before the first level rolls its blocks
+    seed_world(world, seed);
+    if (replay_file != nullptr) {
+        if (!load_input_log(replay_file, replay_log)) {
+            TraceLog(LOG_WARNING, "Cannot replay %s", replay_file);
+        } else {
+            replaying = true;
+            if (!apply_input_log_settings(replay_log, world)) {
+                TraceLog(LOG_WARNING, "The levels differ from the ones %s was recorded with", replay_file);
+            }
+            if (replay_log.header.ball_count != 1) {
+                TraceLog(LOG_WARNING, "%s was recorded with %llu balls, the game plays with one", replay_file,
+                    static_cast<unsigned long long>(replay_log.header.ball_count));
+            }
+        }
+    } else if (record_file != nullptr) {
+        recording = begin_input_recording(record_file, recorder, world);
+        if (!recording) {
+            TraceLog(LOG_WARNING, "Cannot record to %s", record_file);
+        }
+    }
+
+    if (!recording && !replaying) {
+        init_rewind_buffer(rewind_history);
+    }
 
-    load_fonts();
-    load_textures();
-    load_sounds(); // Music is loaded here
+    load_level(world); // Initial load
+    handle_game_events();
 
-    load_level(); // Initial load
+    // Frame pacing aims for the monitor's refresh; without vsync it caps the frame rate there
+    const int monitor_rate = GetMonitorRefreshRate(GetCurrentMonitor());
+    const int refresh_rate = monitor_rate > 0 ? monitor_rate : 60;
+    const double frame_period = 1.0 / refresh_rate;
+    if (frame_pacing) {
+        TraceLog(LOG_INFO, "Low-latency mode, pacing frames to %d Hz", refresh_rate);
+    } else if (low_latency) {
+        TraceLog(LOG_INFO, "Low-latency mode without frame pacing");
+    }
 
+    double swap_time = GetTime();
+    double input_time = swap_time;
+    bool first_frame = true;
     while (!WindowShouldClose()) {
-        BeginDrawing();
+        if (!are_assets_loaded() && update_asset_loading()) {
+            // The level was baked before the atlas existed
+            bake_level_layer(world);
+            TraceLog(LOG_INFO, "Assets fully loaded after %.1f ms", get_asset_loading_time() * 1000.0);
+            log_asset_memory();
+        }
+
+        if (low_latency) {
+            // The late poll below forgets the presses EndDrawing() polled, so take them first
+            if (are_assets_loaded() && !replaying) {
+                latch_input(poll_input());
+            }
+            handle_function_keys();
+            if (frame_pacing) {
+                const double sleep = get_frame_pacing_sleep(frame_latency, frame_period, swap_time, GetTime());
+                if (sleep > 0.0) {
+                    PROFILE_ZONE("frame_pacing");
+                    WaitTime(sleep);
+                }
+            }
+            PollInputEvents();
+            input_time = GetTime();
+        }
 
-        draw();
         update();
+        handle_function_keys();
 
-        EndDrawing();
+        BeginDrawing();
+        draw(tick_accumulator / tick_duration);
+        if (show_debug_overlay) {
+            draw_debug_overlay();
+        }
+#ifdef BREAKOUT_PROFILER
+        if (show_profiler_overlay) {
+            draw_profiler_overlay();
+        }
+#endif
+        const double work_end_time = GetTime();
+        {
+            PROFILE_ZONE("EndDrawing");
+            EndDrawing();
+        }
+        swap_time = GetTime();
+        record_frame_latency(frame_latency, input_time, work_end_time, swap_time);
+        // Otherwise the input is polled inside EndDrawing(), right after the swap
+        if (!low_latency) {
+            input_time = swap_time;
+        }
+        reset_draw_stats();
+        PROFILE_FRAME();
+
+        if (first_frame) {
+            TraceLog(LOG_INFO, "First frame presented after %.1f ms", get_asset_loading_time() * 1000.0);
+            first_frame = false;
+        }
     }
+
+    if (recording) {
+        end_input_recording(recorder, world);
+    }
+    log_autopilot_runs();
+    const latency_percentiles latency = get_session_latency_percentiles(frame_latency);
+    TraceLog(LOG_INFO, "Input to swap latency over all %zu frames of the session: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms", latency.frames, latency.p50, latency.p90, latency.p99, latency.max);
+    const sound_stats sounds = get_sound_stats();
+    TraceLog(LOG_INFO, "Sound effects: %zu played, %zu merged within a tick, %zu dropped at the voice cap", sounds.played, sounds.merged, sounds.dropped);
+
+    // Let the workers finish before anything gets unloaded
+    update_asset_loading(true);
     CloseWindow();
 
     unload_sounds();
-    unload_level();
+    unload_level(world);
+    unload_level_layer();
     unload_textures();
     unload_fonts();
+    use_loose_assets();
 
     return 0;
 }
@@ -2,7 +2,9 @@
 #define GAME_H
 
 #include "raylib.h"
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 constexpr char VOID = ' ';
@@ -17,17 +19,125 @@ constexpr char RANDOM_MULTI_HIT_BLOCK = '?';
 constexpr char UNBREAKABLE_BLOCK = 'X';
 constexpr char SPEED_POWERUP_BLOCK = 'S';
 
-struct Powerup {
-    Vector2 pos;
-    bool active;
+// The characters above are the authoring vocabulary of level data. While a level is played
+// every cell is decoded into a kind plus hit points, and everything the game needs to know
+// about a kind is looked up in cell_properties_table. A new block type is a new kind, a row
+// in the table and, if it has a character, an entry in decode_cell().
+enum cell_kind : uint8_t {
+    void_cell,
+    wall_cell,
+    block_cell,
+    unbreakable_cell,
+    speed_powerup_cell,
+    multi_hit_cell,
+    random_multi_hit_cell, // Rolled into a multi_hit_cell when the level is loaded
+    paddle_spawn_cell,
+    ball_spawn_cell,
+    boundary_cell,
+    cell_kind_count
 };
-inline std::vector<Powerup> active_powerups;
 
+struct cell {
+    cell_kind kind = void_cell;
+    uint8_t hit_points = 0;
+};
+
+enum cell_texture : uint8_t {
+    no_cell_texture,
+    wall_cell_texture,
+    block_cell_texture
+};
+
+struct cell_properties {
+    bool solid; // The ball bounces off it
+    bool destructible; // A hit takes one hit point, the cell disappears at zero
+    bool counts_as_block; // Has to be destroyed to clear the level
+    bool drops_powerup;
+    bool reports_hits; // Every hit is reported as an event (and heard)
+    bool shows_hit_points;
+    cell_texture texture;
+    Color tint;
+    Color background;
+};
+
+inline constexpr cell_properties cell_properties_table[cell_kind_count] = {
+    /* void_cell */ { false, false, false, false, false, false, no_cell_texture, WHITE, BLANK },
+    /* wall_cell */ { true, false, false, false, false, false, wall_cell_texture, WHITE, BLANK },
+    /* block_cell */ { true, true, true, false, false, false, block_cell_texture, WHITE, BLANK },
+    /* unbreakable_cell */ { true, false, false, false, true, false, wall_cell_texture, GRAY, DARKGRAY },
+    /* speed_powerup_cell */ { true, true, true, true, false, false, block_cell_texture, ORANGE, BLANK },
+    /* multi_hit_cell */ { true, true, true, false, true, true, block_cell_texture, WHITE, BLANK },
+    /* random_multi_hit_cell */ { true, true, true, false, true, false, block_cell_texture, PURPLE, BLANK },
+    /* paddle_spawn_cell */ { false, false, false, false, false, false, no_cell_texture, WHITE, BLANK },
+    /* ball_spawn_cell */ { false, false, false, false, false, false, no_cell_texture, WHITE, BLANK },
+    /* boundary_cell */ { false, false, false, false, false, false, no_cell_texture, WHITE, BLANK },
+};
+
+inline constexpr int min_random_hit_points = 2;
+inline constexpr int max_random_hit_points = 11;
+
+// Labels drawn on multi-hit blocks, indexed by hit points
+inline constexpr const char* hit_point_labels[max_random_hit_points + 1] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11"
+};
+
+constexpr cell decode_cell(const char data)
+{
+    switch (data) {
+    case WALL:
+        return { wall_cell, 0 };
+    case BLOCKS:
+        return { block_cell, 1 };
+    case UNBREAKABLE_BLOCK:
+        return { unbreakable_cell, 0 };
+    case SPEED_POWERUP_BLOCK:
+        return { speed_powerup_cell, 1 };
+    case RANDOM_MULTI_HIT_BLOCK:
+        return { random_multi_hit_cell, 0 };
+    case PADDLE:
+        return { paddle_spawn_cell, 0 };
+    case BALL:
+        return { ball_spawn_cell, 0 };
+    case BOUNDARY:
+        return { boundary_cell, 0 };
+    case 'A':
+        return { multi_hit_cell, 10 };
+    case 'B':
+        return { multi_hit_cell, 11 };
+    default:
+        if (data >= '1' && data <= '9') {
+            return { multi_hit_cell, static_cast<uint8_t>(data - '0') };
+        }
+        return { void_cell, 0 };
+    }
+}
+
+// decode_cell() for every possible character, so decoding a level is one lookup per cell
+inline constexpr std::array<cell, 256> cell_decode_table = [] {
+    std::array<cell, 256> table {};
+    for (int i = 0; i < 256; ++i) {
+        table[i] = decode_cell(static_cast<char>(i));
+    }
+    return table;
+}();
+
+constexpr const cell_properties& get_cell_properties(const cell target)
+{
+    return cell_properties_table[target.kind];
+}
+
+// Level data in the authoring vocabulary, as in the built-in levels below
 struct level {
     size_t rows = 0, columns = 0;
     char* data = nullptr;
 };
 
+// The level being played, a copy of its source that the game is free to change
+struct cell_grid {
+    size_t rows = 0, columns = 0;
+    std::vector<cell> cells; // rows * columns, row by row
+};
+
 enum game_state {
     menu_state,
     in_game_state,
@@ -141,6 +251,4 @@ inline level levels[level_count] = {
     level_1, level_2, level_3, level_4, level_5
 };
 
-inline game_state game_state = menu_state;
-
 #endif // GAME_H
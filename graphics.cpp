@@ -2,14 +2,24 @@
 
 #include "assets.h"
 #include "ball.h"
+#include "game.h"
+#include "latency.h"
 #include "level.h"
 #include "paddle.h"
+#include "particles.h"
+#include "pickup.h"
+#include "profiler.h"
+#include "world.h"
 
 #include "raylib.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
 #include <string>
+#include <vector>
 
 struct Text {
     std::string str;
@@ -23,10 +33,20 @@ struct Text {
 constexpr float cell_scale = 0.6f;
 constexpr float screen_scale_divisor = 700.0f;
 
+constexpr float camera_follow_rate = 6.0f; // Share of the distance to the target closed per second, roughly
+constexpr float camera_paddle_margin = 0.2f; // Share of the screen kept below the paddle while the ball is near
+
 constexpr size_t victory_ball_launch_degree_offset = 3;
 constexpr size_t victory_balls_count = 360 / victory_ball_launch_degree_offset;
-constexpr float victory_balls_speed = 7.0f;
-constexpr float victory_balls_size = 3.0f;
+constexpr float victory_balls_speed = 420.0f; // Pixels per second
+constexpr float victory_balls_size = 6.0f;
+constexpr float victory_firework_interval = 0.4f; // Seconds
+constexpr Color victory_firework_colors[] = { RED, GOLD, LIME, SKYBLUE, VIOLET, ORANGE };
+
+// Speeds and sizes in cells, scaled to pixels when emitted
+constexpr particle_burst block_debris_burst = { 24, 0.0f, 360.0f, 2.0f, 9.0f, 0.4f, 0.9f, 0.3f, 0.15f, LIGHTGRAY };
+constexpr particle_burst paddle_spark_burst = { 12, 30.0f, 150.0f, 4.0f, 12.0f, 0.15f, 0.35f, 0.15f, 0.1f, YELLOW };
+constexpr float effect_gravity = 30.0f; // Cells per second squared
 
 // Variables defined inline in header
 // Vector2 screen_size;
@@ -34,48 +54,234 @@ constexpr float victory_balls_size = 3.0f;
 // float cell_size;
 // Vector2 shift_to_center;
 
-Vector2 victory_balls_pos[victory_balls_count];
-Vector2 victory_balls_vel[victory_balls_count];
+// Debris and sparks over the level, in pixels from the level's top left corner so they scroll
+// with the camera, and the bouncing balls and fireworks of the victory screen in screen pixels
+particle_system effect_particles;
+particle_system victory_particles;
+float victory_firework_timer = 0.0f;
+size_t victory_firework_count = 0;
+
+// All balls play the same animation in step, so one instance covers them
+sprite ball_sprite;
+
+// What the camera looks at, in cells; snapped to its target after a level is loaded
+Vector2 camera_center;
+bool camera_snap = true;
+
+struct level_cell_position {
+    size_t row, column;
+};
+
+RenderTexture2D level_layer;
+
+enum draw_layer : unsigned char {
+    level_background_draw_layer, // Camera mode only, like the label layer
+    level_draw_layer,
+    level_label_draw_layer,
+    paddle_draw_layer,
+    ball_draw_layer,
+    pickup_draw_layer
+};
+
+// One textured quad recorded during the frame; submitted sorted by layer, shader and texture
+struct draw_command {
+    const Texture2D* texture;
+    Rectangle source;
+    Rectangle destination;
+    Color tint;
+    draw_layer layer;
+    const Shader* shader = nullptr; // The default shader when null
+};
+
+std::vector<draw_command> draw_commands;
+// raylib's texture for untextured shapes, so plain rectangles can go through the command list
+Texture2D shapes_texture;
+// raylib's built-in font, which the pickup labels are set in
+Font default_font;
+std::vector<level_cell_position> dirty_level_cells;
 
-size_t game_frame = 0;
+Vector2 interpolate(const Vector2 from, const Vector2 to, const float alpha)
+{
+    return { from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha };
+}
 
-void draw_image(const Texture2D& image, const float x, const float y, const float width, const float height)
+void draw_image(const Texture2D& texture, const Rectangle source, const float x, const float y, const float width, const float height, const Color tint = WHITE)
 {
-    const Rectangle source = { 0.0f, 0.0f, static_cast<float>(image.width), static_cast<float>(image.height) };
     const Rectangle destination = { x, y, width, height };
-    DrawTexturePro(image, source, destination, { 0.0f, 0.0f }, 0.0f, WHITE);
+    DrawTexturePro(texture, source, destination, { 0.0f, 0.0f }, 0.0f, tint);
 }
 
-void draw_image(const Texture2D& image, const float x, const float y, const float size)
+void draw_image(const Texture2D& texture, const Rectangle source, const float x, const float y, const float size, const Color tint = WHITE)
 {
-    draw_image(image, x, y, size, size);
+    draw_image(texture, source, x, y, size, size, tint);
 }
 
-void draw_sprite(sprite& sprite, const float x, const float y, const float width, const float height)
+void queue_image(const Texture2D& texture, const Rectangle source, const Rectangle destination, const Color tint, const draw_layer layer, const Shader* shader = nullptr)
 {
-    draw_image(sprite.frames[sprite.frame_index], x, y, width, height);
+    draw_commands.push_back({ &texture, source, destination, tint, layer, shader });
+}
 
-    if (sprite.prev_game_frame == game_frame) {
-        return;
+void queue_rectangle(const Rectangle destination, const Color color, const draw_layer layer)
+{
+    shapes_texture = GetShapesTexture();
+    queue_image(shapes_texture, GetShapesTextureRectangle(), destination, color, layer);
+}
+
+// One quad per glyph, placed the way DrawTextEx() places them
+void queue_font_text(const Font& font, const char* text, Vector2 pos, const float size, const float spacing, const Color color, const draw_layer layer)
+{
+    const Shader* shader = menu_font_sdf && font.texture.id == menu_font.texture.id ? &sdf_font_shader : nullptr;
+    const float scale = size / static_cast<float>(font.baseSize);
+    const float padding = static_cast<float>(font.glyphPadding);
+    for (const char* c = text; *c != '\0'; ++c) {
+        const int index = GetGlyphIndex(font, static_cast<unsigned char>(*c));
+        const Rectangle rec = font.recs[index];
+        const GlyphInfo& glyph = font.glyphs[index];
+        if (*c != ' ') {
+            const Rectangle source = { rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding };
+            const Rectangle destination = {
+                pos.x + (static_cast<float>(glyph.offsetX) - padding) * scale,
+                pos.y + (static_cast<float>(glyph.offsetY) - padding) * scale,
+                source.width * scale,
+                source.height * scale
+            };
+            queue_image(font.texture, source, destination, color, layer, shader);
+        }
+        pos.x += (glyph.advanceX == 0 ? rec.width : static_cast<float>(glyph.advanceX)) * scale + spacing;
     }
-    if (sprite.frames_skipped < sprite.frames_to_skip) {
-        ++sprite.frames_skipped;
-    } else {
-        sprite.frames_skipped = 0;
+}
+
+void submit_draw_commands()
+{
+    PROFILE_ZONE("submit_draw_commands");
 
-        ++sprite.frame_index;
-        if (sprite.frame_index >= sprite.frame_count) {
-            sprite.frame_index = sprite.loop ? 0 : sprite.frame_count - 1;
+    // Stable, so commands with the same layer, shader and texture keep their submission order
+    std::stable_sort(draw_commands.begin(), draw_commands.end(), [](const draw_command& a, const draw_command& b) {
+        if (a.layer != b.layer) {
+            return a.layer < b.layer;
+        }
+        const unsigned int a_shader = a.shader != nullptr ? a.shader->id : 0;
+        const unsigned int b_shader = b.shader != nullptr ? b.shader->id : 0;
+        return a_shader != b_shader ? a_shader < b_shader : a.texture->id < b.texture->id;
+    });
+
+    unsigned int bound_texture = 0;
+    const Shader* bound_shader = nullptr;
+    for (const draw_command& command : draw_commands) {
+        // Switching shaders flushes the batch on the way in and out
+        if (command.shader != bound_shader) {
+            if (bound_shader != nullptr) {
+                EndShaderMode();
+                ++frame_draw_stats.batch_flushes;
+            }
+            if (command.shader != nullptr) {
+                BeginShaderMode(*command.shader);
+                ++frame_draw_stats.batch_flushes;
+            }
+            bound_shader = command.shader;
+            bound_texture = 0;
         }
+        if (command.texture->id != bound_texture) {
+            bound_texture = command.texture->id;
+            ++frame_draw_stats.draw_calls;
+        }
+        DrawTexturePro(*command.texture, command.source, command.destination, { 0.0f, 0.0f }, 0.0f, command.tint);
+    }
+    if (bound_shader != nullptr) {
+        EndShaderMode();
+        ++frame_draw_stats.batch_flushes;
+    }
+    frame_draw_stats.quads += draw_commands.size();
+    draw_commands.clear();
+}
+
+void reset_draw_stats()
+{
+    // EndDrawing() flushed the batch once more
+    ++frame_draw_stats.batch_flushes;
+    last_frame_draw_stats = frame_draw_stats;
+    frame_draw_stats = {};
+}
+
+void draw_debug_overlay()
+{
+    std::string stats = "FPS " + std::to_string(GetFPS())
+        + "  QUADS " + std::to_string(last_frame_draw_stats.quads)
+        + "  DRAW CALLS " + std::to_string(last_frame_draw_stats.draw_calls)
+        + "  FLUSHES " + std::to_string(last_frame_draw_stats.batch_flushes);
+    const latency_percentiles latency = get_latency_percentiles(frame_latency);
+    char latency_text[64];
+    std::snprintf(latency_text, sizeof(latency_text), "  LATENCY P50 %.1f P99 %.1f MS", latency.p50, latency.p99);
+    stats += latency_text;
+    DrawRectangle(0, 0, MeasureText(stats.c_str(), 20) + 20, 30, Fade(BLACK, 0.7f));
+    DrawText(stats.c_str(), 10, 5, 20, GREEN);
+}
+
+#ifdef BREAKOUT_PROFILER
+void draw_profiler_overlay()
+{
+    constexpr int graph_x = 10;
+    constexpr int graph_y = 40;
+    constexpr int graph_height = 100;
+    constexpr int bar_width = 2;
+    constexpr float graph_max_ms = 1000.0f / 30.0f;
+    constexpr size_t zone_frames = 60;
+    constexpr size_t zone_rows = 8;
+
+    // Frame-time graph, one bar per frame, with lines at 60 and 30 FPS
+    const std::vector<float> frame_times = get_profile_frame_times();
+    const int graph_width = static_cast<int>(frame_times.size()) * bar_width;
+    DrawRectangle(graph_x, graph_y, std::max(graph_width, 200), graph_height, Fade(BLACK, 0.7f));
+    for (size_t i = 0; i < frame_times.size(); ++i) {
+        const float ms = frame_times[i];
+        const int height = static_cast<int>(std::min(ms / graph_max_ms, 1.0f) * graph_height);
+        const Color color = ms <= 1000.0f / 60.0f + 0.5f ? GREEN : ms <= graph_max_ms ? YELLOW : RED;
+        DrawRectangle(graph_x + static_cast<int>(i) * bar_width, graph_y + graph_height - height, bar_width, height, color);
+    }
+    for (const float line_ms : { 1000.0f / 60.0f, graph_max_ms }) {
+        const int y = graph_y + graph_height - static_cast<int>(line_ms / graph_max_ms * graph_height);
+        DrawLine(graph_x, y, graph_x + std::max(graph_width, 200), y, Fade(WHITE, 0.5f));
+    }
+
+    // The zones that took the most time, averaged over the last frames
+    const std::vector<profile_zone_total> totals = get_profile_zone_totals(zone_frames);
+    const int rows = static_cast<int>(std::min(totals.size(), zone_rows));
+    const int list_y = graph_y + graph_height + 5;
+    DrawRectangle(graph_x, list_y, 360, 10 + rows * 20, Fade(BLACK, 0.7f));
+    char line[128];
+    for (int i = 0; i < rows; ++i) {
+        std::snprintf(line, sizeof(line), "%-24s %7.3f ms %6.1f x", totals[i].name,
+            totals[i].milliseconds / zone_frames, static_cast<double>(totals[i].calls) / zone_frames);
+        DrawText(line, graph_x + 5, list_y + 5 + i * 20, 18, GREEN);
     }
-    sprite.prev_game_frame = game_frame;
 }
+#endif
 
-void draw_sprite(sprite& sprite, const float x, const float y, const float size)
+void draw_sprite(const sprite& sprite, const float x, const float y, const float width, const float height)
+{
+    queue_image(atlas_texture, get_sprite_frame(sprite), { x, y, width, height }, WHITE, ball_draw_layer);
+}
+
+void draw_sprite(const sprite& sprite, const float x, const float y, const float size)
 {
     draw_sprite(sprite, x, y, size, size);
 }
 
+void draw_font_text(const Font& font, const char* text, const Vector2 pos, const float size, const float spacing, const Color color)
+{
+    // A distance field font needs its shader; switching shaders flushes the batch on the way in and out
+    const bool sdf = menu_font_sdf && font.texture.id == menu_font.texture.id;
+    if (sdf) {
+        BeginShaderMode(sdf_font_shader);
+        ++frame_draw_stats.batch_flushes;
+    }
+    DrawTextEx(font, text, pos, size, spacing, color);
+    if (sdf) {
+        EndShaderMode();
+        ++frame_draw_stats.batch_flushes;
+    }
+}
+
 void draw_text(const Text& text)
 {
     const auto [x, y] = MeasureTextEx(*text.font, text.str.c_str(), text.size * screen_scale, text.spacing);
@@ -83,25 +289,100 @@ void draw_text(const Text& text)
         screen_size.x * text.position.x - 0.5f * x,
         screen_size.y * text.position.y - 0.5f * y
     };
-    DrawTextEx(*text.font, text.str.c_str(), pos, y, text.spacing, text.color);
+    draw_font_text(*text.font, text.str.c_str(), pos, y, text.spacing, text.color);
+}
+
+float get_max_cell_size()
+{
+    const float width = static_cast<float>(GetScreenWidth());
+    const float height = static_cast<float>(GetScreenHeight());
+
+    float result = 0.0f;
+    for (size_t i = 0; i < get_level_count(); ++i) {
+        const level_info level = get_source_level(i);
+        if (level.rows > 0 && level.columns > 0) {
+            const float fit_cell_size = std::min(width / static_cast<float>(level.columns), height / static_cast<float>(level.rows));
+            result = std::max(result, camera_enabled ? std::max(fit_cell_size, camera_cell_size) : fit_cell_size);
+        }
+    }
+
+    return result;
 }
 
-void derive_graphics_metrics()
+void advance_sprites(const float elapsed)
+{
+    if (ball_sprite.animation == nullptr) {
+        play_sprite(ball_sprite, ball_animation);
+    }
+    advance_sprite(ball_sprite, elapsed);
+}
+
+void derive_graphics_metrics(const game_world& world)
 {
     screen_size.x = static_cast<float>(GetScreenWidth());
     screen_size.y = static_cast<float>(GetScreenHeight());
 
-    cell_size = std::min(screen_size.x / static_cast<float>(current_level.columns), screen_size.y / static_cast<float>(current_level.rows));
+    const float fit_cell_size = std::min(screen_size.x / static_cast<float>(world.level.columns), screen_size.y / static_cast<float>(world.level.rows));
+    camera_active = camera_enabled && fit_cell_size < camera_cell_size;
+    cell_size = camera_active ? camera_cell_size : fit_cell_size;
     screen_scale = std::min(screen_size.x, screen_size.y) / screen_scale_divisor;
+    camera_snap = true;
 
-    const float level_width = static_cast<float>(current_level.columns) * cell_size;
-    const float level_height = static_cast<float>(current_level.rows) * cell_size;
+    const float level_width = static_cast<float>(world.level.columns) * cell_size;
+    const float level_height = static_cast<float>(world.level.rows) * cell_size;
     shift_to_center = {
         (screen_size.x - level_width) * 0.5f,
         (screen_size.y - level_height)
     };
 }
 
+// Keeps a level larger than the screen from scrolling past its edges; smaller ones are centered
+// horizontally and sit on the bottom of the screen, as without the camera
+float clamp_camera_shift(const float shift, const float level_extent, const float screen_extent, const float small_shift)
+{
+    if (level_extent <= screen_extent) {
+        return small_shift;
+    }
+    return std::min(std::max(shift, screen_extent - level_extent), 0.0f);
+}
+
+void update_camera(const game_world& world, const float alpha, const float elapsed)
+{
+    if (!camera_active) {
+        return;
+    }
+
+    // Follow the lowest ball, but keep the paddle near the bottom of the screen while the ball is close to it
+    const Vector2 paddle = interpolate(world.paddle_prev_pos, world.paddle_pos, alpha);
+    Vector2 ball = { paddle.x + paddle_size.x * 0.5f - ball_size.x * 0.5f, paddle.y };
+    for (size_t i = 0; i < world.balls.size(); ++i) {
+        const Vector2 pos = interpolate(get_ball_prev_pos(world.balls, i), get_ball_pos(world.balls, i), alpha);
+        if (i == 0 || pos.y > ball.y) {
+            ball = pos;
+        }
+    }
+    const float visible_rows = screen_size.y / cell_size;
+    const Vector2 target = {
+        ball.x + ball_size.x * 0.5f,
+        std::min(ball.y, paddle.y + paddle_size.y - visible_rows * (0.5f - camera_paddle_margin))
+    };
+
+    if (camera_snap) {
+        camera_center = target;
+        camera_snap = false;
+    } else {
+        const float follow = 1.0f - std::exp(-camera_follow_rate * elapsed);
+        camera_center = interpolate(camera_center, target, follow);
+    }
+
+    const float level_width = static_cast<float>(world.level.columns) * cell_size;
+    const float level_height = static_cast<float>(world.level.rows) * cell_size;
+    shift_to_center = {
+        clamp_camera_shift(screen_size.x * 0.5f - camera_center.x * cell_size, level_width, screen_size.x, (screen_size.x - level_width) * 0.5f),
+        clamp_camera_shift(screen_size.y * 0.5f - camera_center.y * cell_size, level_height, screen_size.y, screen_size.y - level_height)
+    };
+}
+
 void draw_menu()
 {
     ClearBackground(BLACK);
@@ -116,8 +397,9 @@ void draw_menu()
     };
     draw_text(game_title);
 
+    // Enter is ignored until the assets are in
     const Text game_subtitle = {
-        "Press Enter to Start",
+        are_assets_loaded() ? "Press Enter to Start" : "Loading",
         { 0.50f, 0.65f },
         32.0f,
         WHITE,
@@ -127,10 +409,12 @@ void draw_menu()
     draw_text(game_subtitle);
 }
 
-void draw_ui()
+void draw_ui(const game_world& world)
 {
+    PROFILE_ZONE("draw_ui");
+
     const Text level_counter = {
-        "LEVEL " + std::to_string(current_level_index + 1) + " OUT OF " + std::to_string(level_count),
+        "LEVEL " + std::to_string(world.level_index + 1) + " OUT OF " + std::to_string(get_level_count()),
         { 0.5f, 0.0375f },
         48.0f,
         WHITE,
@@ -140,7 +424,7 @@ void draw_ui()
     draw_text(level_counter);
 
     const Text boxes_remaining = {
-        "BLOCKS " + std::to_string(current_level_blocks),
+        "BLOCKS " + std::to_string(world.level_blocks),
         { 0.5f, 0.9625f },
         48.0f,
         WHITE,
@@ -150,86 +434,195 @@ void draw_ui()
     draw_text(boxes_remaining);
 }
 
-void draw_level()
+// Atlas regions for each cell_texture
+const Rectangle* const cell_texture_regions[] = { nullptr, &wall_region, &block_region };
+
+void draw_level_cell(const cell data, const float texture_x_pos, const float texture_y_pos)
 {
+    const cell_properties& properties = get_cell_properties(data);
+    if (properties.texture == no_cell_texture) {
+        return;
+    }
+
+    if (properties.background.a != 0) {
+        DrawRectangleRec({ texture_x_pos, texture_y_pos, cell_size, cell_size }, properties.background);
+    }
+    draw_image(atlas_texture, *cell_texture_regions[properties.texture], texture_x_pos, texture_y_pos, cell_size, properties.tint);
+
+    if (properties.shows_hit_points) {
+        // Center the health number, font size relative to cell size
+        const char* label = hit_point_labels[data.hit_points];
+        const float font_size = cell_size * 0.8f;
+        const Vector2 text_size = MeasureTextEx(menu_font, label, font_size, 1.0f);
+        const Vector2 text_pos = {
+            texture_x_pos + (cell_size - text_size.x) / 2.0f,
+            texture_y_pos + (cell_size - text_size.y) / 2.0f
+        };
+        draw_font_text(menu_font, label, text_pos, font_size, 1.0f, BLACK);
+    }
+}
+
+void render_level_cell(const game_world& world, const size_t row, const size_t column)
+{
+    const float texture_x_pos = static_cast<float>(column) * cell_size;
+    const float texture_y_pos = static_cast<float>(row) * cell_size;
+    DrawRectangleRec({ texture_x_pos, texture_y_pos, cell_size, cell_size }, BLACK);
+    draw_level_cell(get_level_cell(world, row, column), texture_x_pos, texture_y_pos);
+}
+
+void bake_level_layer(const game_world& world)
+{
+    PROFILE_ZONE("bake_level_layer");
+
+    // With the camera the visible cells are drawn every frame instead, see queue_visible_level_cells()
+    if (camera_active) {
+        unload_level_layer();
+        dirty_level_cells.clear();
+        return;
+    }
+
+    const int width = static_cast<int>(std::ceil(static_cast<float>(world.level.columns) * cell_size));
+    const int height = static_cast<int>(std::ceil(static_cast<float>(world.level.rows) * cell_size));
+    if (level_layer.texture.width != width || level_layer.texture.height != height) {
+        unload_level_layer();
+        level_layer = LoadRenderTexture(width, height);
+    }
+
+    BeginTextureMode(level_layer);
     ClearBackground(BLACK);
+    for (size_t row = 0; row < world.level.rows; ++row) {
+        for (size_t column = 0; column < world.level.columns; ++column) {
+            draw_level_cell(get_level_cell(world, row, column), static_cast<float>(column) * cell_size, static_cast<float>(row) * cell_size);
+        }
+    }
+    EndTextureMode();
+
+    dirty_level_cells.clear();
+}
+
+void unload_level_layer()
+{
+    if (level_layer.id != 0) {
+        UnloadRenderTexture(level_layer);
+        level_layer = {};
+    }
+}
 
-    for (size_t row = 0; row < current_level.rows; ++row) {
-        for (size_t column = 0; column < current_level.columns; ++column) {
-            const char data = current_level.data[row * current_level.columns + column];
+void mark_level_cell_dirty(const size_t row, const size_t column)
+{
+    dirty_level_cells.push_back({ row, column });
+}
+
+// The command list version of draw_level_cell(): the background, the block and its label each
+// go to a layer of their own, so they still stack right after sorting by texture
+void queue_level_cell(const cell data, const float texture_x_pos, const float texture_y_pos)
+{
+    const cell_properties& properties = get_cell_properties(data);
+    if (properties.texture == no_cell_texture) {
+        return;
+    }
+
+    const Rectangle destination = { texture_x_pos, texture_y_pos, cell_size, cell_size };
+    if (properties.background.a != 0) {
+        queue_rectangle(destination, properties.background, level_background_draw_layer);
+    }
+    queue_image(atlas_texture, *cell_texture_regions[properties.texture], destination, properties.tint, level_draw_layer);
+
+    if (properties.shows_hit_points) {
+        const char* label = hit_point_labels[data.hit_points];
+        const float font_size = cell_size * 0.8f;
+        const Vector2 text_size = MeasureTextEx(menu_font, label, font_size, 1.0f);
+        const Vector2 text_pos = {
+            texture_x_pos + (cell_size - text_size.x) / 2.0f,
+            texture_y_pos + (cell_size - text_size.y) / 2.0f
+        };
+        queue_font_text(menu_font, label, text_pos, font_size, 1.0f, BLACK, level_label_draw_layer);
+    }
+}
+
+// Only the cells intersecting the screen, so the cost depends on the screen size and not the level's
+void queue_visible_level_cells(const game_world& world)
+{
+    const auto first_visible = [](const float shift) {
+        return static_cast<size_t>(std::max(0.0f, std::floor(-shift / cell_size)));
+    };
+    const auto end_visible = [](const float shift, const float screen_extent, const size_t count) {
+        return std::min(count, static_cast<size_t>(std::max(0.0f, std::ceil((screen_extent - shift) / cell_size))));
+    };
+    const size_t first_row = first_visible(shift_to_center.y);
+    const size_t end_row = end_visible(shift_to_center.y, screen_size.y, world.level.rows);
+    const size_t first_column = first_visible(shift_to_center.x);
+    const size_t end_column = end_visible(shift_to_center.x, screen_size.x, world.level.columns);
+
+    for (size_t row = first_row; row < end_row; ++row) {
+        for (size_t column = first_column; column < end_column; ++column) {
             const float texture_x_pos = shift_to_center.x + static_cast<float>(column) * cell_size;
             const float texture_y_pos = shift_to_center.y + static_cast<float>(row) * cell_size;
+            queue_level_cell(get_level_cell(world, row, column), texture_x_pos, texture_y_pos);
+        }
+    }
+}
 
-            switch (data) {
-            case WALL:
-                draw_image(wall_texture, texture_x_pos, texture_y_pos, cell_size);
-                break;
-            case BLOCKS:
-                draw_image(block_texture, texture_x_pos, texture_y_pos, cell_size);
-                break;
-            case UNBREAKABLE_BLOCK:
-                // Draw darker/different wall
-                DrawRectangle(texture_x_pos, texture_y_pos, cell_size, cell_size, DARKGRAY);
-                // Or just tint the wall texture
-                {
-                    Rectangle source = { 0.0f, 0.0f, static_cast<float>(wall_texture.width), static_cast<float>(wall_texture.height) };
-                    Rectangle destination = { texture_x_pos, texture_y_pos, cell_size, cell_size };
-                    DrawTexturePro(wall_texture, source, destination, { 0.0f, 0.0f }, 0.0f, GRAY);
-                }
-                break;
-            case SPEED_POWERUP_BLOCK:
-                // Draw block with tint or overlay
-                {
-                    Rectangle source = { 0.0f, 0.0f, static_cast<float>(block_texture.width), static_cast<float>(block_texture.height) };
-                    Rectangle destination = { texture_x_pos, texture_y_pos, cell_size, cell_size };
-                    DrawTexturePro(block_texture, source, destination, { 0.0f, 0.0f }, 0.0f, ORANGE);
-                    // Draw 'S'? logic
-                    // Actually let's just use text for simplicity and clarity
-                }
-                break;
-            default:
-                // Handle Multi-Hit
-                if ((data >= '1' && data <= '9') || data == 'A' || data == 'B') {
-                    // Draw Block
-                    draw_image(block_texture, texture_x_pos, texture_y_pos, cell_size);
-
-                    // Draw Health Number
-                    std::string health_str;
-                    if (data == 'A')
-                        health_str = "10";
-                    else if (data == 'B')
-                        health_str = "11";
-                    else
-                        health_str = std::string(1, data);
-
-                    // Center the text
-                    // Font size relative to cell size
-                    float fontSize = cell_size * 0.8f;
-                    Vector2 textSize = MeasureTextEx(menu_font, health_str.c_str(), fontSize, 1.0f);
-                    Vector2 textPos = {
-                        texture_x_pos + (cell_size - textSize.x) / 2.0f,
-                        texture_y_pos + (cell_size - textSize.y) / 2.0f
-                    };
-
-                    DrawTextEx(menu_font, health_str.c_str(), textPos, fontSize, 1.0f, BLACK);
-                }
-            }
+void draw_level(const game_world& world)
+{
+    PROFILE_ZONE("draw_level");
+
+    ClearBackground(BLACK);
+
+    if (camera_active) {
+        dirty_level_cells.clear();
+        queue_visible_level_cells(world);
+        return;
+    }
+
+    if (!dirty_level_cells.empty()) {
+        // Switching render targets flushes the batch on the way in and on the way out
+        frame_draw_stats.batch_flushes += 2;
+        BeginTextureMode(level_layer);
+        for (const auto& [row, column] : dirty_level_cells) {
+            render_level_cell(world, row, column);
         }
+        EndTextureMode();
+        dirty_level_cells.clear();
     }
+
+    // Render textures are stored upside down, hence the negative source height
+    const Rectangle source = { 0.0f, 0.0f, static_cast<float>(level_layer.texture.width), -static_cast<float>(level_layer.texture.height) };
+    const Rectangle destination = { shift_to_center.x, shift_to_center.y, static_cast<float>(level_layer.texture.width), static_cast<float>(level_layer.texture.height) };
+    queue_image(level_layer.texture, source, destination, WHITE, level_draw_layer);
 }
 
-void draw_paddle()
+void draw_paddle(const game_world& world, const float alpha)
 {
-    const float texture_x_pos = shift_to_center.x + paddle_pos.x * cell_size;
-    const float texture_y_pos = shift_to_center.y + paddle_pos.y * cell_size;
-    draw_image(paddle_texture, texture_x_pos, texture_y_pos, paddle_size.x * cell_size, paddle_size.y * cell_size);
+    const Vector2 pos = interpolate(world.paddle_prev_pos, world.paddle_pos, alpha);
+    const float texture_x_pos = shift_to_center.x + pos.x * cell_size;
+    const float texture_y_pos = shift_to_center.y + pos.y * cell_size;
+    queue_image(atlas_texture, paddle_region, { texture_x_pos, texture_y_pos, paddle_size.x * cell_size, paddle_size.y * cell_size }, WHITE, paddle_draw_layer);
 }
 
-void draw_ball()
+void draw_ball(const game_world& world, const float alpha)
 {
-    const float texture_x_pos = shift_to_center.x + ball_pos.x * cell_size;
-    const float texture_y_pos = shift_to_center.y + ball_pos.y * cell_size;
-    draw_sprite(ball_sprite, texture_x_pos, texture_y_pos, cell_size);
+    for (size_t i = 0; i < world.balls.size(); ++i) {
+        const Vector2 pos = interpolate(get_ball_prev_pos(world.balls, i), get_ball_pos(world.balls, i), alpha);
+        const float texture_x_pos = shift_to_center.x + pos.x * cell_size;
+        const float texture_y_pos = shift_to_center.y + pos.y * cell_size;
+        draw_sprite(ball_sprite, texture_x_pos, texture_y_pos, cell_size);
+    }
+}
+
+void draw_pickups(const game_world& world)
+{
+    // Sized and spaced the way DrawText() sets the default font
+    default_font = GetFontDefault();
+    const int font_size = std::max(static_cast<int>(cell_size), 10);
+    const pickup_pool& pickups = world.pickups;
+    for (size_t i = 0; i < pickups.size(); ++i) {
+        const pickup_properties& properties = pickup_properties_table[pickups.kind[i]];
+        const float texture_x_pos = shift_to_center.x + pickups.pos[i].x * cell_size;
+        const float texture_y_pos = shift_to_center.y + pickups.pos[i].y * cell_size;
+        const Vector2 pos = { std::floor(texture_x_pos + cell_size / 4), std::floor(texture_y_pos) };
+        queue_font_text(default_font, properties.label, pos, static_cast<float>(font_size), static_cast<float>(font_size / 10), properties.tint, pickup_draw_layer);
+    }
 }
 
 void draw_pause_menu()
@@ -261,40 +654,93 @@ void draw_pause_menu()
 
 void init_victory_menu()
 {
+    clear_particles(victory_particles);
+    victory_particles.bounce = true;
+    victory_particles.bounds = { 0.0f, 0.0f, screen_size.x, screen_size.y };
+    victory_firework_timer = 0.0f;
+    victory_firework_count = 0;
+
     for (size_t i = 0; i < victory_balls_count; ++i) {
-        victory_balls_pos[i] = { screen_size.x / 2, screen_size.y / 2 };
-        victory_balls_vel[i] = {
+        const Vector2 vel = {
             std::cos(static_cast<float>(i * victory_ball_launch_degree_offset)) * victory_balls_speed,
             std::sin(static_cast<float>(i * victory_ball_launch_degree_offset)) * victory_balls_speed
         };
+        emit_particle(victory_particles, { screen_size.x / 2, screen_size.y / 2 }, vel, INFINITY, 0.0f, victory_balls_size, WHITE);
     }
 }
 
-void animate_victory_menu()
+void launch_victory_firework()
 {
-    for (size_t i = 0; i < victory_balls_count; ++i) {
-        if (victory_balls_pos[i].x + victory_balls_vel[i].x > screen_size.x || victory_balls_pos[i].x + victory_balls_vel[i].x < 0) {
-            victory_balls_vel[i].x *= -1.0f;
-        }
-        if (victory_balls_pos[i].y + victory_balls_vel[i].y > screen_size.y || victory_balls_pos[i].y + victory_balls_vel[i].y < 0) {
-            victory_balls_vel[i].y *= -1.0f;
+    // Spread over the top half of the screen, cycling through the colors
+    const float x = screen_size.x * (0.2f + 0.6f * static_cast<float>((victory_firework_count * 7) % 11) / 10.0f);
+    const float y = screen_size.y * (0.15f + 0.3f * static_cast<float>((victory_firework_count * 3) % 5) / 4.0f);
+    const particle_burst burst = {
+        400, 0.0f, 360.0f, 60.0f * screen_scale, 360.0f * screen_scale, 0.8f, 1.6f, 0.6f, 4.0f * screen_scale,
+        victory_firework_colors[victory_firework_count % std::size(victory_firework_colors)]
+    };
+    emit_particles(victory_particles, { x, y }, burst);
+    ++victory_firework_count;
+}
+
+particle_burst scale_to_cells(particle_burst burst)
+{
+    burst.min_speed *= cell_size;
+    burst.max_speed *= cell_size;
+    burst.size *= cell_size;
+    return burst;
+}
+
+void emit_block_debris(const Vector2 cell)
+{
+    const Vector2 center = { (cell.x + 0.5f) * cell_size, (cell.y + 0.5f) * cell_size };
+    emit_particles(effect_particles, center, scale_to_cells(block_debris_burst));
+}
+
+void emit_paddle_sparks(const Vector2 ball_pos)
+{
+    const Vector2 contact = { (ball_pos.x + ball_size.x * 0.5f) * cell_size, (ball_pos.y + ball_size.y) * cell_size };
+    emit_particles(effect_particles, contact, scale_to_cells(paddle_spark_burst));
+}
+
+void init_effects()
+{
+    init_particle_system(effect_particles);
+    init_particle_system(victory_particles);
+}
+
+void clear_effects()
+{
+    clear_particles(effect_particles);
+}
+
+void advance_particles(const game_world& world, const float elapsed)
+{
+    // Debris freezes with the game while it is paused
+    if (world.state != paused_state) {
+        effect_particles.gravity = effect_gravity * cell_size;
+        update_particles(effect_particles, elapsed);
+    }
+
+    if (world.state == victory_state) {
+        victory_firework_timer += elapsed;
+        while (victory_firework_timer >= victory_firework_interval) {
+            victory_firework_timer -= victory_firework_interval;
+            launch_victory_firework();
         }
-        victory_balls_pos[i] = {
-            victory_balls_pos[i].x + victory_balls_vel[i].x,
-            victory_balls_pos[i].y + victory_balls_vel[i].y
-        };
+        update_particles(victory_particles, elapsed);
     }
 }
 
-void draw_victory_menu()
+void draw_effects()
 {
-    animate_victory_menu();
+    draw_particles(effect_particles, shift_to_center);
+}
 
+void draw_victory_menu()
+{
     DrawRectangleV({ 0.0f, 0.0f }, { screen_size.x, screen_size.y }, { 0, 0, 0, 50 });
 
-    for (const auto& [x, y] : victory_balls_pos) {
-        DrawCircleV({ x, y }, victory_balls_size, WHITE);
-    }
+    draw_particles(victory_particles);
 
     const Text victory_title = {
         "Victory!",
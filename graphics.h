@@ -3,21 +3,72 @@
 
 #include "raylib.h"
 
+#include <cstddef>
+
+struct game_world;
+
 // Expose metrics
 inline Vector2 screen_size;
 inline float screen_scale;
 inline float cell_size;
 inline Vector2 shift_to_center;
 
-void derive_graphics_metrics();
+// Levels that would need cells smaller than camera_cell_size to fit on screen are drawn at that
+// size instead, with a camera following the ball and only the cells in view drawn
+inline constexpr float camera_cell_size = 24.0f; // Pixels
+inline bool camera_enabled = true;
+inline bool camera_active = false;
+
+// The metrics for the world's level; call whenever a level is loaded
+void derive_graphics_metrics(const game_world& world);
+// Moves the camera towards the ball and updates shift_to_center; call before drawing the level
+void update_camera(const game_world& world, float alpha, float elapsed);
+// Moves the sprite animations on by elapsed seconds of simulation time
+void advance_sprites(float elapsed);
+// Particle effects, see particles.h. They advance with simulation time too, so they freeze with
+// the game when it is paused.
+void init_effects();
+void clear_effects();
+void advance_particles(const game_world& world, float elapsed);
+void emit_block_debris(Vector2 cell);
+void emit_paddle_sparks(Vector2 ball_pos);
+void draw_effects();
+// The largest cell_size any of the levels gets at the current screen size
+float get_max_cell_size();
 
 void draw_text(const char* text, float x, float y, float size, Color color);
 
+// draw_level(), draw_paddle(), draw_ball() and draw_pickups() record textured quads;
+// submit_draw_commands() sorts them by layer and texture and issues them in as few texture runs
+// as possible.
+struct draw_stats {
+    size_t quads = 0; // Quads submitted through the command list
+    size_t draw_calls = 0; // Texture runs while submitting; rlgl issues one draw call per run
+    size_t batch_flushes = 0; // Forced flushes of rlgl's batch (render target switches, end of frame)
+};
+
+inline draw_stats frame_draw_stats;
+inline draw_stats last_frame_draw_stats;
+
+void submit_draw_commands();
+void reset_draw_stats();
+void draw_debug_overlay();
+#ifdef BREAKOUT_PROFILER
+// Frame-time graph and the most expensive zones, see profiler.h
+void draw_profiler_overlay();
+#endif
+
 void draw_menu();
-void draw_ui();
-void draw_level();
-void draw_paddle();
-void draw_ball();
+void draw_ui(const game_world& world);
+// The level is rendered once into an offscreen layer; only cells marked dirty are re-rendered
+void bake_level_layer(const game_world& world);
+void unload_level_layer();
+void mark_level_cell_dirty(size_t row, size_t column);
+void draw_level(const game_world& world);
+// alpha is how far the renderer is between the previous and the current simulation tick
+void draw_paddle(const game_world& world, float alpha = 1.0f);
+void draw_ball(const game_world& world, float alpha = 1.0f);
+void draw_pickups(const game_world& world);
 void draw_pause_menu();
 void draw_victory_menu();
 void draw_game_over_menu();
@@ -0,0 +1,232 @@
+#include "autopilot.h"
+#include "ball.h"
+#include "game.h"
+#include "input_log.h"
+#include "level.h"
+#include "level_generator.h"
+#include "paddle.h"
+#include "random.h"
+#include "simulation.h"
+#include "world.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Runs the simulation without a window, GPU or audio device.
+// The paddle simply follows the ball, and the game restarts whenever it ends. With --replay
+// the input comes from a recorded session instead, replayed as fast as the CPU allows.
+
+struct headless_options {
+    size_t ticks = 1000000;
+    const char* level_file = nullptr;
+    const char* scene = nullptr;
+    int start_level = 0;
+    size_t ball_count = 1;
+    uint64_t seed = 1;
+    const char* record_file = nullptr;
+    const char* replay_file = nullptr;
+    bool autopilot = false; // Instead of following the ball
+};
+
+bool parse_options(const int argc, char** argv, headless_options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            options.ticks = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            set_tick_rate(static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--collision") == 0 && i + 1 < argc) {
+            ++i;
+            ball_collision_mode = std::strcmp(argv[i], "discrete") == 0 ? discrete_collision_mode : swept_collision_mode;
+        } else if (std::strcmp(argv[i], "--balls") == 0 && i + 1 < argc) {
+            options.ball_count = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            options.level_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            options.scene = argv[++i];
+        } else if (std::strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            options.start_level = std::atoi(argv[++i]) - 1;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--autopilot") == 0) {
+            options.autopilot = true;
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options.record_file = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replay_file = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--ticks N] [--tick-rate HZ] [--collision swept|discrete] [--balls N] [--levels FILE | --scene NAME] [--level N] [--seed N] [--autopilot] [--record FILE | --replay FILE]\n", argv[0]);
+            return false;
+        }
+    }
+    if (options.level_file != nullptr && !use_level_file(options.level_file)) {
+        std::fprintf(stderr, "cannot load levels from %s\n", options.level_file);
+        return false;
+    }
+    if (options.scene != nullptr) {
+        const stress_scene* scene = find_stress_scene(options.scene);
+        if (scene == nullptr) {
+            std::fprintf(stderr, "there is no scene %s, the scenes are:\n", options.scene);
+            for (const stress_scene& known : stress_scenes) {
+                std::fprintf(stderr, "  %-8s %s\n", known.name, known.description);
+            }
+            return false;
+        }
+        use_generated_level(scene->params);
+    }
+    if (options.start_level < 0 || options.start_level >= static_cast<int>(get_level_count())) {
+        std::fprintf(stderr, "level must be between 1 and %zu\n", get_level_count());
+        return false;
+    }
+
+    return true;
+}
+
+// Extra balls fan out from the first one, for stress runs
+void add_extra_balls(game_world& world, const size_t ball_count)
+{
+    if (world.balls.empty()) {
+        return;
+    }
+    const Vector2 pos = get_ball_pos(world.balls, 0);
+    for (size_t i = 1; i < ball_count; ++i) {
+        launch_ball(world.balls, pos, 20.0f + 140.0f * static_cast<float>(i) / static_cast<float>(ball_count));
+    }
+}
+
+input_state follow_ball_policy(const game_world& world, const headless_options& options)
+{
+    input_state input;
+    if (world.state == menu_state) {
+        input.selected_level = options.start_level;
+    } else if (world.state == game_over_state || world.state == victory_state) {
+        input.confirm = true;
+    } else {
+        // Chase the lowest ball
+        const ball_set& balls = world.balls;
+        size_t lowest = 0;
+        for (size_t i = 1; i < balls.size(); ++i) {
+            if (balls.pos_y[i] > balls.pos_y[lowest]) {
+                lowest = i;
+            }
+        }
+        const float paddle_center = world.paddle_pos.x + paddle_size.x * 0.5f;
+        const float ball_center = balls.empty() ? paddle_center : balls.pos_x[lowest] + ball_size.x * 0.5f;
+        const float paddle_step = paddle_speed * tick_duration;
+        input.move_left = ball_center < paddle_center - paddle_step;
+        input.move_right = ball_center > paddle_center + paddle_step;
+    }
+
+    return input;
+}
+
+int main(const int argc, char** argv)
+{
+    headless_options options;
+    if (!parse_options(argc, argv, options)) {
+        return EXIT_FAILURE;
+    }
+
+    game_world world;
+    seed_world(world, options.seed);
+
+    input_log replay_log;
+    if (options.replay_file != nullptr) {
+        if (!load_input_log(options.replay_file, replay_log)) {
+            std::fprintf(stderr, "cannot replay %s\n", options.replay_file);
+            return EXIT_FAILURE;
+        }
+        if (!apply_input_log_settings(replay_log, world)) {
+            std::fprintf(stderr, "warning: the levels differ from the ones %s was recorded with\n", options.replay_file);
+        }
+        options.ticks = replay_log.ticks.size();
+        options.ball_count = replay_log.header.ball_count;
+    }
+
+    input_recorder recorder;
+    if (options.record_file != nullptr && !begin_input_recording(options.record_file, recorder, world, options.ball_count)) {
+        std::fprintf(stderr, "cannot record to %s\n", options.record_file);
+        return EXIT_FAILURE;
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    load_level(world);
+    const std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+    world.state = menu_state;
+
+    autopilot pilot;
+    pilot.level = options.start_level;
+    level_run_tracker runs;
+
+    size_t levels_cleared = 0;
+    size_t balls_lost = 0;
+    size_t games_completed = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t tick = 0; tick < options.ticks; ++tick) {
+        input_state input;
+        if (options.replay_file != nullptr) {
+            input = unpack_input(replay_log.ticks[tick]);
+        } else if (options.autopilot) {
+            input = drive_autopilot(world, pilot);
+        } else {
+            input = follow_ball_policy(world, options);
+        }
+        if (options.record_file != nullptr) {
+            record_input(recorder, input);
+        }
+        simulate_tick(world, input);
+        track_level_runs(runs, world, tick);
+
+        for (const auto& event : world.events) {
+            if (event.type == level_cleared_event) {
+                ++levels_cleared;
+            } else if (event.type == ball_lost_event) {
+                ++balls_lost;
+            } else if (event.type == game_completed_event) {
+                ++games_completed;
+            } else if (event.type == level_loaded_event) {
+                add_extra_balls(world, options.ball_count);
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const level_info first_level = get_source_level(options.start_level);
+    std::printf("level:            %zu x %zu, %zu blocks\n", first_level.rows, first_level.columns, first_level.blocks);
+    std::printf("first level load: %.3f ms\n", load_time.count());
+    std::printf("ticks:            %zu\n", options.ticks);
+    std::printf("elapsed:          %.3f s\n", elapsed.count());
+    std::printf("ticks per second: %.0f\n", static_cast<double>(options.ticks) / elapsed.count());
+    std::printf("simulated time:   %.0f s at %.0f Hz\n", static_cast<double>(options.ticks) * tick_duration, tick_rate);
+    std::printf("levels cleared:   %zu\n", levels_cleared);
+    std::printf("games completed:  %zu\n", games_completed);
+    std::printf("balls lost:       %zu\n", balls_lost);
+    std::printf("state hash:       %016llx\n", static_cast<unsigned long long>(hash_game_state(world)));
+    for (size_t level = 0; level < runs.levels.size(); ++level) {
+        if (runs.levels[level].attempts > 0) {
+            char line[128];
+            format_level_run(line, sizeof(line), level, runs.levels[level]);
+            std::printf("%s\n", line);
+        }
+    }
+
+    bool replay_matches = true;
+    if (options.replay_file != nullptr) {
+        if (!replay_log.finished) {
+            std::printf("replay:           unverified, the recording was not finished\n");
+        } else {
+            replay_matches = hash_game_state(world) == replay_log.header.final_state_hash;
+            std::printf("replay:           %s\n", replay_matches ? "matches the recording" : "DIFFERS from the recording");
+        }
+    }
+    if (options.record_file != nullptr && !end_input_recording(recorder, world)) {
+        std::fprintf(stderr, "cannot finish %s\n", options.record_file);
+    }
+
+    unload_level(world);
+
+    return replay_matches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
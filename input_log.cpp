@@ -0,0 +1,163 @@
+#include "input_log.h"
+
+#include "ball.h"
+#include "level.h"
+#include "world.h"
+
+#include <cstdio>
+#include <cstring>
+
+constexpr uint16_t move_left_bit = 1u << 0;
+constexpr uint16_t move_right_bit = 1u << 1;
+constexpr uint16_t toggle_pause_bit = 1u << 2;
+constexpr uint16_t confirm_bit = 1u << 3;
+constexpr uint16_t back_to_menu_bit = 1u << 4;
+constexpr int selected_level_shift = 8; // The high byte holds selected_level + 1, 0 for none
+
+uint64_t hash_level_set()
+{
+    uint64_t hash = 14695981039346656037ull;
+    const auto mix = [&hash](const void* data, const size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    for (size_t i = 0; i < get_level_count(); ++i) {
+        const level_info level = get_source_level(i);
+        const uint64_t header[] = {
+            level.rows, level.columns,
+            static_cast<uint64_t>(level.ball_row), static_cast<uint64_t>(level.ball_column),
+            static_cast<uint64_t>(level.paddle_row), static_cast<uint64_t>(level.paddle_column)
+        };
+        mix(header, sizeof(header));
+        // The cells as the game decodes them, with the spawn markers blanked: the built-in levels
+        // keep theirs in the grid while level files clear them, and the spawns are in the header
+        for (size_t j = 0; j < level.rows * level.columns; ++j) {
+            cell decoded = cell_decode_table[static_cast<unsigned char>(level.data[j])];
+            if (decoded.kind == ball_spawn_cell || decoded.kind == paddle_spawn_cell) {
+                decoded = {};
+            }
+            const uint8_t bytes[] = { static_cast<uint8_t>(decoded.kind), decoded.hit_points };
+            mix(bytes, sizeof(bytes));
+        }
+    }
+
+    return hash;
+}
+
+uint16_t pack_input(const input_state& input)
+{
+    uint16_t packed = 0;
+    packed |= input.move_left ? move_left_bit : 0;
+    packed |= input.move_right ? move_right_bit : 0;
+    packed |= input.toggle_pause ? toggle_pause_bit : 0;
+    packed |= input.confirm ? confirm_bit : 0;
+    packed |= input.back_to_menu ? back_to_menu_bit : 0;
+    if (input.selected_level >= 0 && input.selected_level < 255) {
+        packed |= static_cast<uint16_t>((input.selected_level + 1) << selected_level_shift);
+    }
+    return packed;
+}
+
+input_state unpack_input(const uint16_t packed)
+{
+    input_state input;
+    input.move_left = (packed & move_left_bit) != 0;
+    input.move_right = (packed & move_right_bit) != 0;
+    input.toggle_pause = (packed & toggle_pause_bit) != 0;
+    input.confirm = (packed & confirm_bit) != 0;
+    input.back_to_menu = (packed & back_to_menu_bit) != 0;
+    input.selected_level = (packed >> selected_level_shift) - 1;
+    return input;
+}
+
+bool begin_input_recording(const char* path, input_recorder& recorder, const game_world& world, const size_t ball_count)
+{
+    recorder.header = {};
+    std::memcpy(recorder.header.magic, input_log_magic, sizeof(recorder.header.magic));
+    recorder.header.version = input_log_version;
+    recorder.header.seed = world.seed;
+    recorder.header.tick_rate = tick_rate;
+    recorder.header.collision_mode = ball_collision_mode;
+    recorder.header.level_set_hash = hash_level_set();
+    recorder.header.ball_count = ball_count;
+
+    recorder.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!recorder.file) {
+        return false;
+    }
+    recorder.file.write(reinterpret_cast<const char*>(&recorder.header), sizeof(recorder.header));
+
+    return static_cast<bool>(recorder.file);
+}
+
+void record_input(input_recorder& recorder, const input_state& input)
+{
+    const uint16_t packed = pack_input(input);
+    recorder.file.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+    ++recorder.header.tick_count;
+    if (recorder.header.tick_count % input_log_flush_ticks == 0) {
+        recorder.file.flush();
+    }
+}
+
+bool end_input_recording(input_recorder& recorder, const game_world& world)
+{
+    if (!recorder.file.is_open()) {
+        return false;
+    }
+
+    recorder.header.final_state_hash = hash_game_state(world);
+    recorder.file.seekp(0);
+    recorder.file.write(reinterpret_cast<const char*>(&recorder.header), sizeof(recorder.header));
+    recorder.file.close();
+
+    return !recorder.file.fail();
+}
+
+bool load_input_log(const char* path, input_log& log)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&log.header), sizeof(log.header));
+    if (!file
+        || std::memcmp(log.header.magic, input_log_magic, sizeof(log.header.magic)) != 0
+        || log.header.version != input_log_version) {
+        std::fprintf(stderr, "%s is not an input log\n", path);
+        return false;
+    }
+
+    // Only end_input_recording() fills in the count; without it, every whole tick in the file counts
+    log.finished = log.header.tick_count != 0;
+    if (!log.finished) {
+        file.seekg(0, std::ios::end);
+        const auto size = static_cast<uint64_t>(file.tellg());
+        log.header.tick_count = (size - sizeof(log.header)) / sizeof(uint16_t);
+        file.seekg(sizeof(log.header));
+        std::fprintf(stderr, "%s was not finished, replaying the %llu ticks it holds without checking the final state\n", path,
+            static_cast<unsigned long long>(log.header.tick_count));
+    }
+
+    log.ticks.resize(log.header.tick_count);
+    file.read(reinterpret_cast<char*>(log.ticks.data()), static_cast<std::streamsize>(log.ticks.size() * sizeof(uint16_t)));
+    if (!file) {
+        std::fprintf(stderr, "%s is truncated\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+bool apply_input_log_settings(const input_log& log, game_world& world)
+{
+    seed_world(world, log.header.seed);
+    set_tick_rate(log.header.tick_rate);
+    ball_collision_mode = static_cast<collision_mode>(log.header.collision_mode);
+
+    return log.header.level_set_hash == hash_level_set();
+}
@@ -0,0 +1,68 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include "simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+struct game_world;
+
+// A recorded session: everything needed to re-run it, then one packed input_state per tick.
+// Replaying the ticks from the same seed, tick rate, collision mode and levels reproduces the
+// session bit for bit, which final_state_hash confirms.
+//   input_log_header, then uint16_t[tick_count]
+inline constexpr char input_log_magic[4] = { 'B', 'K', 'I', 'L' };
+// Version 2: restarting a level restores it as first dealt instead of rolling its blocks again
+// Version 3: the ball count
+inline constexpr uint32_t input_log_version = 3;
+
+struct input_log_header {
+    char magic[4];
+    uint32_t version;
+    uint64_t seed;
+    float tick_rate;
+    uint32_t collision_mode;
+    uint64_t level_set_hash;
+    uint64_t ball_count; // Balls launched on every level load, breakout_headless --balls
+    uint64_t tick_count; // Filled in when the recording ends
+    uint64_t final_state_hash; // hash_game_state() after the last tick
+};
+
+struct input_recorder {
+    std::ofstream file;
+    input_log_header header {};
+};
+
+struct input_log {
+    input_log_header header {};
+    std::vector<uint16_t> ticks;
+    // False for a log whose recording never ended, e.g. the game crashed. The ticks are then
+    // taken from the file size and there is no final state hash to check the replay against.
+    bool finished = true;
+};
+
+// Hashes the source levels, so a replay can tell it is running against different levels. The
+// same levels hash the same whether they are built in or come from a level file or pack.
+uint64_t hash_level_set();
+
+uint16_t pack_input(const input_state& input);
+input_state unpack_input(uint16_t packed);
+
+// Call right after seeding the world and before its first tick
+bool begin_input_recording(const char* path, input_recorder& recorder, const game_world& world, size_t ball_count = 1);
+// Call with exactly what goes into simulate_tick(), once per tick. The ticks reach the file at
+// least every input_log_flush_ticks, so a crash loses little more than that.
+inline constexpr uint64_t input_log_flush_ticks = 256;
+void record_input(input_recorder& recorder, const input_state& input);
+bool end_input_recording(input_recorder& recorder, const game_world& world);
+
+bool load_input_log(const char* path, input_log& log);
+// Seeds the world and sets the tick rate and collision mode the log was recorded with. The
+// caller launches header.ball_count balls on every level load.
+// Returns false if the levels differ from the recording's; the replay will then diverge.
+bool apply_input_log_settings(const input_log& log, game_world& world);
+
+#endif // INPUT_LOG_H
@@ -0,0 +1,83 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+void record_frame_latency(frame_latency_tracker& tracker, const double input_time, const double work_end_time, const double swap_time)
+{
+    const auto latency_ms = static_cast<float>((swap_time - input_time) * 1000.0);
+    tracker.latency_ms[tracker.frames % latency_sample_capacity] = latency_ms;
+    const auto bucket = static_cast<size_t>(std::max(latency_ms, 0.0f) / latency_bucket_ms);
+    ++tracker.session_buckets[std::min(bucket, latency_bucket_count - 1)];
+    tracker.session_max_ms = std::max(tracker.session_max_ms, latency_ms);
+    tracker.work_ms[tracker.frames % pacing_work_window] = static_cast<float>((work_end_time - input_time) * 1000.0);
+    ++tracker.frames;
+}
+
+// Nearest rank
+float get_sorted_percentile(const float* sorted, const size_t count, const double fraction)
+{
+    const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(count)));
+    return sorted[std::clamp(rank, size_t { 1 }, count) - 1];
+}
+
+latency_percentiles get_latency_percentiles(const frame_latency_tracker& tracker)
+{
+    latency_percentiles result;
+    result.frames = std::min(tracker.frames, latency_sample_capacity);
+    if (result.frames == 0) {
+        return result;
+    }
+
+    std::array<float, latency_sample_capacity> sorted = tracker.latency_ms;
+    std::sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(result.frames));
+    result.p50 = get_sorted_percentile(sorted.data(), result.frames, 0.50);
+    result.p90 = get_sorted_percentile(sorted.data(), result.frames, 0.90);
+    result.p99 = get_sorted_percentile(sorted.data(), result.frames, 0.99);
+    result.max = sorted[result.frames - 1];
+
+    return result;
+}
+
+// The upper edge of the bucket holding the nearest-rank value
+float get_bucket_percentile(const frame_latency_tracker& tracker, const size_t frames, const double fraction)
+{
+    const auto rank = std::clamp(static_cast<size_t>(std::ceil(fraction * static_cast<double>(frames))), size_t { 1 }, frames);
+    size_t seen = 0;
+    for (size_t bucket = 0; bucket < latency_bucket_count; ++bucket) {
+        seen += tracker.session_buckets[bucket];
+        if (seen >= rank) {
+            return std::min(static_cast<float>(bucket + 1) * latency_bucket_ms, tracker.session_max_ms);
+        }
+    }
+    return tracker.session_max_ms;
+}
+
+latency_percentiles get_session_latency_percentiles(const frame_latency_tracker& tracker)
+{
+    latency_percentiles result;
+    result.frames = tracker.frames;
+    if (result.frames == 0) {
+        return result;
+    }
+
+    result.p50 = get_bucket_percentile(tracker, result.frames, 0.50);
+    result.p90 = get_bucket_percentile(tracker, result.frames, 0.90);
+    result.p99 = get_bucket_percentile(tracker, result.frames, 0.99);
+    result.max = tracker.session_max_ms;
+
+    return result;
+}
+
+double get_frame_pacing_sleep(const frame_latency_tracker& tracker, const double frame_period, const double swap_time, const double now)
+{
+    // Until there is a window of frames to go by, do not risk missing a vblank
+    if (tracker.frames < pacing_work_window || frame_period <= 0.0) {
+        return 0.0;
+    }
+
+    const double work = *std::max_element(std::begin(tracker.work_ms), std::end(tracker.work_ms)) / 1000.0;
+    const double poll_time = swap_time + frame_period - work - pacing_margin;
+    return std::max(poll_time - now, 0.0);
+}
@@ -0,0 +1,57 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Input-to-swap latency: from the moment the keyboard was last polled before a frame's tick to
+// the moment its buffer swap returned. The swap returning is as close to the screen as raylib
+// lets us look; time spent queued in the driver or on scanout is not included.
+//
+// Low-latency mode polls the input again right before the tick instead of relying on the poll
+// EndDrawing() does after the previous swap, and frame pacing sleeps after the swap so that
+// this poll happens as late as the recent frames allow while still making the next vblank.
+
+inline constexpr size_t latency_sample_capacity = 1024; // Frames the recent percentiles cover
+// The whole session goes into a histogram instead, in steps of latency_bucket_ms; anything
+// past the last bucket counts as that bucket and only shows in the max
+inline constexpr float latency_bucket_ms = 0.1f;
+inline constexpr size_t latency_bucket_count = 2000;
+inline constexpr size_t pacing_work_window = 60; // Frames the work estimate covers
+
+// The pacing aims to call EndDrawing() this long before the next vblank
+inline constexpr double pacing_margin = 0.002; // Seconds
+
+struct frame_latency_tracker {
+    std::array<float, latency_sample_capacity> latency_ms = {};
+    // From the input poll until EndDrawing() was called: the part of the frame pacing cannot skip
+    std::array<float, pacing_work_window> work_ms = {};
+    size_t frames = 0;
+
+    std::array<uint64_t, latency_bucket_count> session_buckets = {};
+    float session_max_ms = 0.0f;
+};
+
+struct latency_percentiles {
+    float p50 = 0.0f;
+    float p90 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+    size_t frames = 0; // Frames the percentiles were taken over
+};
+
+inline frame_latency_tracker frame_latency;
+
+// All times in seconds from GetTime()
+void record_frame_latency(frame_latency_tracker& tracker, double input_time, double work_end_time, double swap_time);
+// Over the last latency_sample_capacity frames
+latency_percentiles get_latency_percentiles(const frame_latency_tracker& tracker);
+// Over every frame recorded, to the resolution of the histogram
+latency_percentiles get_session_latency_percentiles(const frame_latency_tracker& tracker);
+
+// Seconds to sleep after a swap that returned at swap_time before polling the input, so that the
+// slowest of the recent frames would still finish pacing_margin before the next one is due
+double get_frame_pacing_sleep(const frame_latency_tracker& tracker, double frame_period, double swap_time, double now);
+
+#endif // LATENCY_H
@@ -2,103 +2,164 @@
 
 #include "ball.h"
 #include "game.h"
-#include "graphics.h"
 #include "paddle.h"
+#include "pickup.h"
+#include "profiler.h"
+#include "random.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "world.h"
 
 #include "raylib.h"
 
-char* current_level_data;
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
 
-void load_level(const int offset)
+std::vector<char> text_level_storage;
+std::vector<level_info> text_levels;
+level_pack opened_level_pack;
+
+bool use_level_file(const char* path)
 {
-    current_level_index += offset;
+    use_builtin_levels();
 
-    if (current_level_index >= level_count) {
-        game_state = victory_state;
-        ClearBackground(BLACK);
-        init_victory_menu();
-        current_level_index = 0;
+    const std::string_view name(path);
+    if (name.size() >= 5 && name.substr(name.size() - 5) == ".pack") {
+        return open_level_pack(path, opened_level_pack);
+    }
 
-        return;
+    return load_level_text(path, text_level_storage, text_levels);
+}
+
+bool use_level_text(const char* text, const size_t size)
+{
+    use_builtin_levels();
+
+    return parse_level_text(text, size, text_level_storage, text_levels);
+}
+
+bool use_generated_level(const level_generator_params& params)
+{
+    const std::string text = generate_level_text(params);
+
+    return !text.empty() && use_level_text(text.data(), text.size());
+}
+
+void use_builtin_levels()
+{
+    close_level_pack(opened_level_pack);
+    text_levels.clear();
+    text_level_storage.clear();
+}
+
+size_t get_level_count()
+{
+    if (opened_level_pack.header != nullptr) {
+        return get_level_pack_count(opened_level_pack);
+    }
+    if (!text_levels.empty()) {
+        return text_levels.size();
+    }
+    return level_count;
+}
+
+level_info get_source_level(const size_t index)
+{
+    if (opened_level_pack.header != nullptr) {
+        // open_level_pack() checked every entry, so this only fails for an index past the end
+        level_info level;
+        if (!get_level_pack_level(opened_level_pack, index, level)) {
+            std::fprintf(stderr, "the level pack has no level %zu\n", index + 1);
+        }
+        return level;
+    }
+    if (!text_levels.empty()) {
+        return text_levels[index];
     }
+    return describe_level(levels[index].rows, levels[index].columns, levels[index].data);
+}
 
-    const size_t rows = levels[current_level_index].rows;
-    const size_t columns = levels[current_level_index].columns;
-    current_level_blocks = 0;
-    active_powerups.clear(); // Clear powerups on level load
+void load_level(game_world& world, const int offset)
+{
+    PROFILE_ZONE("load_level");
 
-    // We need to copy the data because we will modify it (mutable state for durability)
-    // and we might need to randomize it.
-    delete[] current_level_data; // Delete old data if any
-    current_level_data = new char[rows * columns];
-
-    for (int row = 0; row < rows; ++row) {
-        for (int column = 0; column < columns; ++column) {
-            char cell_info = levels[current_level_index].data[row * columns + column];
-
-            // Handle Random Multi-Hit Block
-            if (cell_info == '?') {
-                int health = GetRandomValue(2, 11);
-                // Convert health to char representation:
-                // 1-9 -> '1'-'9'
-                // 10 -> 'A'
-                // 11 -> 'B'
-                if (health < 10) {
-                    cell_info = '0' + health;
-                } else if (health == 10) {
-                    cell_info = 'A';
-                } else {
-                    cell_info = 'B';
-                }
-            }
+    world.level_index += offset;
 
-            current_level_data[row * columns + column] = cell_info;
+    if (world.level_index >= get_level_count()) {
+        world.state = victory_state;
+        world.level_index = 0;
+        emit_game_event(world, game_completed_event);
 
-            // Count destroyable blocks
-            if (cell_info == BLOCKS || cell_info == SPEED_POWERUP_BLOCK || (cell_info >= '1' && cell_info <= '9') || cell_info == 'A' || cell_info == 'B') {
-                ++current_level_blocks;
-            }
+        return;
+    }
+
+    const level_info source = get_source_level(world.level_index);
+    const size_t rows = source.rows;
+    const size_t columns = source.columns;
+    world.level_blocks = source.blocks;
+    clear_pickups(world.pickups);
+
+    // We need to copy the data because we will modify it (mutable state for durability)
+    // and we might need to randomize it. The grid keeps its allocation from level to level.
+    world.level.rows = rows;
+    world.level.columns = columns;
+    world.level.cells.resize(rows * columns);
+
+    for (size_t i = 0; i < rows * columns; ++i) {
+        cell decoded = cell_decode_table[static_cast<unsigned char>(source.data[i])];
+        // Handle Random Multi-Hit Block
+        if (decoded.kind == random_multi_hit_cell) {
+            decoded = { multi_hit_cell, static_cast<uint8_t>(random_int(world.random, min_random_hit_points, max_random_hit_points)) };
         }
+        world.level.cells[i] = decoded;
     }
-    current_level = { rows, columns, current_level_data };
 
-    spawn_ball();
-    spawn_paddle();
+    spawn_ball(world, source.ball_row, source.ball_column);
+    spawn_paddle(world, source.paddle_row, source.paddle_column);
+    save_world_snapshot(world, world.level_start);
+
+    emit_game_event(world, level_loaded_event);
+}
 
-    derive_graphics_metrics();
+void unload_level(game_world& world)
+{
+    world.level = {};
+    use_builtin_levels();
 }
 
-void unload_level()
+bool is_inside_level(const game_world& world, const int row, const int column)
 {
-    delete[] current_level_data;
+    return row >= 0 && row < world.level.rows && column >= 0 && column < world.level.columns;
 }
 
-bool is_inside_level(const int row, const int column)
+cell& get_level_cell(game_world& world, const size_t row, const size_t column)
 {
-    return row >= 0 && row < current_level.rows && column >= 0 && column < current_level.columns;
+    return world.level.cells[row * world.level.columns + column];
 }
 
-char& get_level_cell(const size_t row, const size_t column)
+const cell& get_level_cell(const game_world& world, const size_t row, const size_t column)
 {
-    return current_level.data[row * current_level.columns + column];
+    return world.level.cells[row * world.level.columns + column];
 }
 
-void set_level_cell(const size_t row, const size_t column, const char cell)
+void set_level_cell(game_world& world, const size_t row, const size_t column, const cell value)
 {
-    get_level_cell(row, column) = cell;
+    get_level_cell(world, row, column) = value;
 }
 
-bool is_colliding_with_level_cell(const Vector2 pos, const Vector2 size, const char cell)
+bool is_colliding_with_level_cell(const game_world& world, const Vector2 pos, const Vector2 size, const cell_kind kind)
 {
     const Rectangle hitbox = { pos.x, pos.y, size.x, size.y };
 
     for (int row = static_cast<int>(pos.y); row <= static_cast<int>(pos.y + size.y); ++row) {
         for (int column = static_cast<int>(pos.x); column <= static_cast<int>(pos.x + size.x); ++column) {
-            if (!is_inside_level(row, column)) {
+            if (!is_inside_level(world, row, column)) {
                 continue;
             }
 
-            if (get_level_cell(row, column) == cell) {
+            if (get_level_cell(world, row, column).kind == kind) {
                 if (const Rectangle block_hitbox = { static_cast<float>(column), static_cast<float>(row), 1.0f, 1.0f }; CheckCollisionRecs(hitbox, block_hitbox)) {
                     return true;
                 }
@@ -109,23 +170,23 @@ bool is_colliding_with_level_cell(const Vector2 pos, const Vector2 size, const c
     return false;
 }
 
-char& get_colliding_level_cell(const Vector2 pos, const Vector2 size, const char look_for)
+cell& get_colliding_level_cell(game_world& world, const Vector2 pos, const Vector2 size, const cell_kind look_for)
 {
     const Rectangle hitbox = { pos.x, pos.y, size.x, size.y };
 
     for (int row = static_cast<int>(pos.y); row <= static_cast<int>(pos.y + size.y); ++row) {
         for (int column = static_cast<int>(pos.x); column <= static_cast<int>(pos.x + size.x); ++column) {
-            if (!is_inside_level(row, column)) {
+            if (!is_inside_level(world, row, column)) {
                 continue;
             }
 
-            if (get_level_cell(row, column) == look_for) {
+            if (get_level_cell(world, row, column).kind == look_for) {
                 if (const Rectangle block_hitbox = { static_cast<float>(column), static_cast<float>(row), 1.0f, 1.0f }; CheckCollisionRecs(hitbox, block_hitbox)) {
-                    return get_level_cell(row, column);
+                    return get_level_cell(world, row, column);
                 }
             }
         }
     }
 
-    return get_level_cell(static_cast<size_t>(pos.x), static_cast<size_t>(pos.y));
+    return get_level_cell(world, static_cast<size_t>(pos.y), static_cast<size_t>(pos.x));
 }
@@ -2,24 +2,40 @@
 #define LEVEL_H
 
 #include "game.h"
+#include "level_file.h"
+#include "level_generator.h"
 
 #include "raylib.h"
 
 #include <cstddef>
 
-inline level current_level;
-inline size_t current_level_blocks;
-inline size_t current_level_index = 0;
-
-void load_level(int offset = 0);
-void unload_level();
-
-bool is_inside_level(int row, int column);
-
-char& get_level_cell(size_t row, size_t column);
-void set_level_cell(size_t row, size_t column, char cell);
-
-bool is_colliding_with_level_cell(Vector2 pos, Vector2 size, char cell = '#');
-char& get_colliding_level_cell(Vector2 pos, Vector2 size, char look_for);
+struct game_world;
+
+// The level sources below are shared by every game_world (see world.h): pick them before any
+// game starts and do not change them while games run on other threads.
+// Levels come from the built-in levels[] array unless a level file is in use.
+// Files ending in .pack are memory mapped, anything else is parsed as level text.
+bool use_level_file(const char* path);
+// Levels in the text format held in memory, e.g. generated ones
+bool use_level_text(const char* text, size_t size);
+// A single generated level, see level_generator.h
+bool use_generated_level(const level_generator_params& params);
+void use_builtin_levels();
+size_t get_level_count();
+level_info get_source_level(size_t index);
+
+// Copies the level world.level_index + offset into the world and spawns the ball and paddle
+void load_level(game_world& world, int offset = 0);
+// Frees the world's copy of the level and goes back to the built-in levels
+void unload_level(game_world& world);
+
+bool is_inside_level(const game_world& world, int row, int column);
+
+cell& get_level_cell(game_world& world, size_t row, size_t column);
+const cell& get_level_cell(const game_world& world, size_t row, size_t column);
+void set_level_cell(game_world& world, size_t row, size_t column, cell cell);
+
+bool is_colliding_with_level_cell(const game_world& world, Vector2 pos, Vector2 size, cell_kind kind = wall_cell);
+cell& get_colliding_level_cell(game_world& world, Vector2 pos, Vector2 size, cell_kind look_for);
 
 #endif // LEVEL_H
@@ -0,0 +1,237 @@
+#include "level_file.h"
+
+#include "game.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+level_info describe_level(const size_t rows, const size_t columns, const char* data)
+{
+    level_info level = { rows, columns, data };
+
+    // Column by column, so the first marker found is the one the original spawn code picked
+    for (size_t column = 0; column < columns; ++column) {
+        for (size_t row = 0; row < rows; ++row) {
+            const char cell = data[row * columns + column];
+            const cell_kind kind = cell_decode_table[static_cast<unsigned char>(cell)].kind;
+            if (cell_properties_table[kind].counts_as_block) {
+                ++level.blocks;
+            }
+            if (kind == random_multi_hit_cell) {
+                ++level.random_blocks;
+            }
+            if (cell == BALL && level.ball_row < 0) {
+                level.ball_row = static_cast<int>(row);
+                level.ball_column = static_cast<int>(column);
+            }
+            if (cell == PADDLE && level.paddle_row < 0) {
+                level.paddle_row = static_cast<int>(row);
+                level.paddle_column = static_cast<int>(column);
+            }
+        }
+    }
+
+    return level;
+}
+
+bool parse_level_text(const char* text, const size_t size, std::vector<char>& storage, std::vector<level_info>& levels)
+{
+    std::vector<std::vector<std::string_view>> grids(1);
+    std::string_view rest(text, size);
+    while (!rest.empty()) {
+        const size_t end = std::min(rest.find('\n'), rest.size());
+        std::string_view line = rest.substr(0, end);
+        rest.remove_prefix(std::min(end + 1, rest.size()));
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if (!line.empty() && line.front() == ';') {
+            continue;
+        }
+        if (line.find_first_not_of(' ') == std::string_view::npos) {
+            if (!grids.back().empty()) {
+                grids.emplace_back();
+            }
+            continue;
+        }
+        grids.back().push_back(line);
+    }
+    if (grids.back().empty()) {
+        grids.pop_back();
+    }
+    if (grids.empty()) {
+        return false;
+    }
+
+    size_t total_cells = 0;
+    std::vector<size_t> widths;
+    for (const auto& grid : grids) {
+        size_t columns = 0;
+        for (const auto& line : grid) {
+            columns = std::max(columns, line.size());
+        }
+        widths.push_back(columns);
+        total_cells += grid.size() * columns;
+    }
+
+    // Filled completely before any level_info points into it
+    storage.assign(total_cells, VOID);
+    size_t offset = 0;
+    std::vector<size_t> offsets;
+    for (size_t i = 0; i < grids.size(); ++i) {
+        offsets.push_back(offset);
+        for (size_t row = 0; row < grids[i].size(); ++row) {
+            std::copy(grids[i][row].begin(), grids[i][row].end(), storage.begin() + static_cast<std::ptrdiff_t>(offset + row * widths[i]));
+        }
+        offset += grids[i].size() * widths[i];
+    }
+
+    levels.clear();
+    for (size_t i = 0; i < grids.size(); ++i) {
+        char* data = storage.data() + offsets[i];
+        level_info level = describe_level(grids[i].size(), widths[i], data);
+        if (level.ball_row >= 0) {
+            data[level.ball_row * level.columns + level.ball_column] = VOID;
+        }
+        if (level.paddle_row >= 0) {
+            data[level.paddle_row * level.columns + level.paddle_column] = VOID;
+        }
+        levels.push_back(level);
+    }
+
+    return true;
+}
+
+bool load_level_text(const char* path, std::vector<char>& storage, std::vector<level_info>& levels)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::vector<char> text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    return parse_level_text(text.data(), text.size(), storage, levels);
+}
+
+size_t align_to_pack(const size_t offset)
+{
+    return (offset + level_pack_alignment - 1) / level_pack_alignment * level_pack_alignment;
+}
+
+bool write_level_pack(const char* path, const std::vector<level_info>& levels)
+{
+    level_pack_header header = {};
+    std::memcpy(header.magic, level_pack_magic, sizeof(header.magic));
+    header.version = level_pack_version;
+    header.level_count = static_cast<uint32_t>(levels.size());
+
+    std::vector<level_pack_entry> entries;
+    size_t offset = align_to_pack(sizeof(level_pack_header) + levels.size() * sizeof(level_pack_entry));
+    for (const level_info& level : levels) {
+        entries.push_back({
+            offset,
+            static_cast<uint32_t>(level.rows), static_cast<uint32_t>(level.columns),
+            static_cast<uint32_t>(level.blocks),
+            static_cast<uint32_t>(level.random_blocks),
+            level.ball_row, level.ball_column,
+            level.paddle_row, level.paddle_column,
+        });
+        offset = align_to_pack(offset + level.rows * level.columns);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(level_pack_entry)));
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const std::vector<char> padding(entries[i].data_offset - static_cast<size_t>(file.tellp()), 0);
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+
+        // Spawn markers live in the entry, the grid keeps empty cells in their place
+        std::vector<char> grid(levels[i].data, levels[i].data + levels[i].rows * levels[i].columns);
+        if (levels[i].ball_row >= 0) {
+            grid[levels[i].ball_row * levels[i].columns + levels[i].ball_column] = VOID;
+        }
+        if (levels[i].paddle_row >= 0) {
+            grid[levels[i].paddle_row * levels[i].columns + levels[i].paddle_column] = VOID;
+        }
+        file.write(grid.data(), static_cast<std::streamsize>(grid.size()));
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool open_level_pack(const char* path, level_pack& pack)
+{
+    if (!map_file(path, pack.file)) {
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const level_pack_header*>(pack.file.data);
+    if (pack.file.size < sizeof(level_pack_header)
+        || std::memcmp(header->magic, level_pack_magic, sizeof(header->magic)) != 0
+        || header->version != level_pack_version
+        || pack.file.size < sizeof(level_pack_header) + header->level_count * sizeof(level_pack_entry)) {
+        std::fprintf(stderr, "%s is not a level pack\n", path);
+        close_level_pack(pack);
+        return false;
+    }
+
+    pack.header = header;
+    pack.entries = reinterpret_cast<const level_pack_entry*>(pack.file.data + sizeof(level_pack_header));
+
+    // A truncated or corrupt entry rejects the whole pack, so levels never come back half read
+    for (size_t i = 0; i < get_level_pack_count(pack); ++i) {
+        level_info level;
+        if (!get_level_pack_level(pack, i, level)) {
+            std::fprintf(stderr, "%s has a damaged level %zu\n", path, i + 1);
+            close_level_pack(pack);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void close_level_pack(level_pack& pack)
+{
+    unmap_file(pack.file);
+    pack.header = nullptr;
+    pack.entries = nullptr;
+}
+
+size_t get_level_pack_count(const level_pack& pack)
+{
+    return pack.header != nullptr ? pack.header->level_count : 0;
+}
+
+bool get_level_pack_level(const level_pack& pack, const size_t index, level_info& level)
+{
+    if (index >= get_level_pack_count(pack)) {
+        return false;
+    }
+
+    const level_pack_entry& entry = pack.entries[index];
+    const size_t cells = static_cast<size_t>(entry.rows) * entry.columns;
+    if (cells == 0 || entry.data_offset > pack.file.size || cells > pack.file.size - entry.data_offset) {
+        return false;
+    }
+
+    level = {
+        entry.rows, entry.columns,
+        reinterpret_cast<const char*>(pack.file.data + entry.data_offset),
+        entry.blocks, entry.random_blocks,
+        entry.ball_row, entry.ball_column,
+        entry.paddle_row, entry.paddle_column
+    };
+
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A level as load_level() consumes it: the cell grid plus everything that would otherwise need a scan.
+struct level_info {
+    size_t rows = 0, columns = 0;
+    const char* data = nullptr;
+    size_t blocks = 0; // Destroyable blocks, random multi-hit blocks included
+    size_t random_blocks = 0; // Random multi-hit blocks still to be rolled
+    int ball_row = -1, ball_column = -1;
+    int paddle_row = -1, paddle_column = -1;
+};
+
+// Scans a grid that still contains the spawn markers, like the built-in levels in game.h
+level_info describe_level(size_t rows, size_t columns, const char* data);
+
+// Text authoring format: one grid per level, levels separated by blank lines, lines starting
+// with ';' are comments and short rows are padded with VOID. Spawn markers are cleared in
+// storage and recorded in the level_info instead. data pointers point into storage.
+bool parse_level_text(const char* text, size_t size, std::vector<char>& storage, std::vector<level_info>& levels);
+bool load_level_text(const char* path, std::vector<char>& storage, std::vector<level_info>& levels);
+
+// Compiled format, used in place through a memory mapping:
+//   level_pack_header, level_pack_entry[level_count], then the grids of all levels,
+//   each starting at a multiple of level_pack_alignment.
+inline constexpr char level_pack_magic[4] = { 'B', 'K', 'L', 'P' };
+inline constexpr uint32_t level_pack_version = 1;
+inline constexpr size_t level_pack_alignment = 64;
+
+struct level_pack_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t level_count;
+    uint32_t reserved;
+};
+
+struct level_pack_entry {
+    uint64_t data_offset;
+    uint32_t rows, columns;
+    uint32_t blocks;
+    uint32_t random_blocks;
+    int32_t ball_row, ball_column;
+    int32_t paddle_row, paddle_column;
+};
+
+struct level_pack {
+    mapped_file file;
+    const level_pack_header* header = nullptr;
+    const level_pack_entry* entries = nullptr;
+};
+
+bool write_level_pack(const char* path, const std::vector<level_info>& levels);
+
+// The header and the level table are checked here; a level's grid is only touched when it is requested
+bool open_level_pack(const char* path, level_pack& pack);
+void close_level_pack(level_pack& pack);
+size_t get_level_pack_count(const level_pack& pack);
+bool get_level_pack_level(const level_pack& pack, size_t index, level_info& level);
+
+#endif // LEVEL_FILE_H
@@ -0,0 +1,100 @@
+#include "level_generator.h"
+
+#include "game.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+constexpr size_t min_generated_rows = 16;
+constexpr size_t min_generated_columns = 8;
+
+std::string generate_level_text(const level_generator_params& params)
+{
+    const size_t rows = params.rows;
+    const size_t columns = params.columns;
+    if (rows < min_generated_rows || columns < min_generated_columns) {
+        return {};
+    }
+
+    // Its own generator, so generating a level leaves the simulation's sequence alone
+    random_generator generator;
+    seed_random(generator, params.seed);
+
+    const float weights[] = {
+        std::max(params.plain_weight, 0.0f),
+        std::max(params.multi_hit_weight, 0.0f),
+        std::max(params.random_multi_hit_weight, 0.0f),
+        std::max(params.unbreakable_weight, 0.0f),
+        std::max(params.powerup_weight, 0.0f)
+    };
+    float total_weight = 0.0f;
+    for (const float weight : weights) {
+        total_weight += weight;
+    }
+
+    // The bottom quarter, at least six rows, is left empty for the ball and paddle
+    const size_t play_rows = std::max<size_t>(6, rows / 4);
+    const size_t block_rows_end = rows - play_rows;
+
+    std::string text(rows * (columns + 1), VOID);
+    for (size_t row = 0; row < rows; ++row) {
+        char* line = text.data() + row * (columns + 1);
+        line[columns] = '\n';
+        line[0] = WALL;
+        line[columns - 1] = WALL;
+        if (row == 0) {
+            std::fill(line, line + columns, WALL);
+            continue;
+        }
+        // One empty row under the top wall, so the ball always has room to turn around
+        if (row < 2 || row >= block_rows_end || total_weight <= 0.0f) {
+            continue;
+        }
+
+        for (size_t column = 1; column + 1 < columns; ++column) {
+            if (random_float(generator, 0.0f, 1.0f) >= params.block_density) {
+                continue;
+            }
+            float pick = random_float(generator, 0.0f, total_weight);
+            size_t kind = 0;
+            while (kind + 1 < std::size(weights) && pick >= weights[kind]) {
+                pick -= weights[kind];
+                ++kind;
+            }
+            switch (kind) {
+            case 0:
+                line[column] = BLOCKS;
+                break;
+            case 1:
+                line[column] = static_cast<char>('0' + random_int(generator, 2, 9));
+                break;
+            case 2:
+                line[column] = RANDOM_MULTI_HIT_BLOCK;
+                break;
+            case 3:
+                line[column] = UNBREAKABLE_BLOCK;
+                break;
+            default:
+                line[column] = SPEED_POWERUP_BLOCK;
+                break;
+            }
+        }
+    }
+
+    text[(rows - 4) * (columns + 1) + columns / 2] = BALL;
+    text[(rows - 2) * (columns + 1) + columns / 2 - 1] = PADDLE;
+
+    return text;
+}
+
+const stress_scene* find_stress_scene(const char* name)
+{
+    for (const stress_scene& scene : stress_scenes) {
+        if (std::strcmp(scene.name, name) == 0) {
+            return &scene;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,47 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Procedural levels in the authoring vocabulary of game.h, for measuring how loading, rendering
+// and collision scale far beyond the built-in levels. The output is level text, so anything
+// that takes level text (use_level_text(), breakout_levelc) takes generated levels.
+//
+// Layout: walls along the top and the sides, blocks in the upper part, an empty strip at the
+// bottom with the ball and paddle spawns, and the bottom row open like in the built-in levels.
+
+struct level_generator_params {
+    size_t rows = 64, columns = 64; // At least 16 by 8
+    float block_density = 0.5f; // Chance of a block in each cell of the block area
+    // Relative weights of the block kinds
+    float plain_weight = 1.0f;
+    float multi_hit_weight = 0.0f; // Fixed hit points from 2 to 9
+    float random_multi_hit_weight = 0.0f; // Rolled when the level is loaded
+    float unbreakable_weight = 0.0f;
+    float powerup_weight = 0.0f;
+    uint64_t seed = 1; // The same parameters and seed always give the same level
+};
+
+// Empty if the size is too small
+std::string generate_level_text(const level_generator_params& params);
+
+// Preset scenes for stress runs, selected by name with --scene
+struct stress_scene {
+    const char* name;
+    const char* description;
+    level_generator_params params;
+};
+
+inline constexpr stress_scene stress_scenes[] = {
+    { "wall", "64x256, densely packed plain blocks", { 64, 256, 0.9f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1 } },
+    { "mixed", "256x256, every block kind", { 256, 256, 0.5f, 4.0f, 2.0f, 1.0f, 1.0f, 0.5f, 2 } },
+    { "huge", "1000x1000, about 100k multi-hit blocks", { 1000, 1000, 0.134f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 3 } },
+    { "giant", "4000x4000, sparse mixed blocks", { 4000, 4000, 0.05f, 4.0f, 1.0f, 1.0f, 1.0f, 0.2f, 4 } },
+};
+
+// nullptr if there is no scene of that name
+const stress_scene* find_stress_scene(const char* name);
+
+#endif // LEVEL_GENERATOR_H
@@ -0,0 +1,48 @@
+#include "level_file.h"
+#include "level_generator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Compiles a level text file, or a generated stress scene, into the memory-mappable .pack format
+int main(const int argc, char** argv)
+{
+    const bool scene = argc == 4 && std::strcmp(argv[1], "--scene") == 0;
+    if (argc != 3 && !scene) {
+        std::fprintf(stderr, "usage: %s levels.txt levels.pack\n       %s --scene NAME levels.pack\n", argv[0], argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char* output = argv[argc - 1];
+
+    std::vector<char> storage;
+    std::vector<level_info> levels;
+    if (scene) {
+        const stress_scene* generated = find_stress_scene(argv[2]);
+        const std::string text = generated != nullptr ? generate_level_text(generated->params) : std::string();
+        if (!parse_level_text(text.data(), text.size(), storage, levels)) {
+            std::fprintf(stderr, "there is no scene %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+    } else if (!load_level_text(argv[1], storage, levels)) {
+        std::fprintf(stderr, "cannot read levels from %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].ball_row < 0 || levels[i].paddle_row < 0) {
+            std::fprintf(stderr, "level %zu has no ball or paddle spawn\n", i + 1);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!write_level_pack(output, levels)) {
+        std::fprintf(stderr, "cannot write %s\n", output);
+        return EXIT_FAILURE;
+    }
+    std::printf("%zu levels written to %s\n", levels.size(), output);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool map_file(const char* path, mapped_file& file)
+{
+    HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_handle, &size) || size.QuadPart == 0) {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    const void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    file.data = static_cast<const std::byte*>(data);
+    file.size = static_cast<size_t>(size.QuadPart);
+    file.file_handle = file_handle;
+    file.mapping_handle = mapping_handle;
+
+    return true;
+}
+
+void unmap_file(mapped_file& file)
+{
+    if (file.data != nullptr) {
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.mapping_handle);
+        CloseHandle(file.file_handle);
+    }
+    file = {};
+}
+
+#else
+
+bool map_file(const char* path, mapped_file& file)
+{
+    const int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    struct stat info {};
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        close(descriptor);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    file.data = static_cast<const std::byte*>(data);
+    file.size = static_cast<size_t>(info.st_size);
+
+    return true;
+}
+
+void unmap_file(mapped_file& file)
+{
+    if (file.data != nullptr) {
+        munmap(const_cast<std::byte*>(file.data), file.size);
+    }
+    file = {};
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// A read-only memory mapping of a whole file. Pages are only read from disk when touched.
+struct mapped_file {
+    const std::byte* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+bool map_file(const char* path, mapped_file& file);
+void unmap_file(mapped_file& file);
+
+#endif // MAPPED_FILE_H
@@ -1,36 +1,33 @@
 #include "paddle.h"
 #include "level.h"
+#include "world.h"
 
 #include "raylib.h"
 
 #include <cmath>
 
-void spawn_paddle()
+void spawn_paddle(game_world& world, const int row, const int column)
 {
-    for (int column = 0; column < current_level.columns; column++) {
-        for (int row = 0; row < current_level.rows; row++) {
-            if (get_level_cell(row, column) == PADDLE) {
-                set_level_cell(row, column, VOID);
-                paddle_pos = { static_cast<float>(column), static_cast<float>(row) };
-                goto outer_loop_end;
-            }
-        }
+    if (!is_inside_level(world, row, column)) {
+        return;
     }
-outer_loop_end:;
+    set_level_cell(world, row, column, {});
+    world.paddle_pos = { static_cast<float>(column), static_cast<float>(row) };
+    world.paddle_prev_pos = world.paddle_pos;
 }
 
-void move_paddle(const float x_offset)
+void move_paddle(game_world& world, const float x_offset)
 {
-    float next_paddle_pos_x = paddle_pos.x + x_offset;
-    if (is_colliding_with_level_cell({ next_paddle_pos_x, paddle_pos.y }, paddle_size, WALL)) {
+    float next_paddle_pos_x = world.paddle_pos.x + x_offset;
+    if (is_colliding_with_level_cell(world, { next_paddle_pos_x, world.paddle_pos.y }, paddle_size, wall_cell)) {
         next_paddle_pos_x = std::round(next_paddle_pos_x);
     }
-    paddle_pos.x = next_paddle_pos_x;
+    world.paddle_pos.x = next_paddle_pos_x;
 }
 
-bool is_colliding_with_paddle(const Vector2 pos, const Vector2 size)
+bool is_colliding_with_paddle(const game_world& world, const Vector2 pos, const Vector2 size)
 {
-    const Rectangle paddle_hitbox = { paddle_pos.x, paddle_pos.y, paddle_size.x, paddle_size.y };
+    const Rectangle paddle_hitbox = { world.paddle_pos.x, world.paddle_pos.y, paddle_size.x, paddle_size.y };
     const Rectangle hitbox = { pos.x, pos.y, size.x, size.y };
     return CheckCollisionRecs(paddle_hitbox, hitbox);
 }
@@ -4,12 +4,12 @@
 #include "raylib.h"
 
 inline constexpr Vector2 paddle_size = { 3.0f, 1.0f };
-inline constexpr float paddle_speed = 0.1f;
+inline constexpr float paddle_speed = 6.0f;
 
-inline Vector2 paddle_pos;
+struct game_world;
 
-void spawn_paddle();
-void move_paddle(float x_offset);
-bool is_colliding_with_paddle(Vector2 pos, Vector2 size);
+void spawn_paddle(game_world& world, int row, int column);
+void move_paddle(game_world& world, float x_offset);
+bool is_colliding_with_paddle(const game_world& world, Vector2 pos, Vector2 size);
 
 #endif // PADDLE_H
@@ -0,0 +1,274 @@
+#include "particles.h"
+
+#include "graphics.h"
+#include "profiler.h"
+#include "random.h"
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE2
+#include <emmintrin.h>
+#endif
+
+// Quads handed to rlgl per run; well inside its default batch of 8192
+constexpr size_t particle_draw_run = 1024;
+
+// Particles are cosmetic, they must not draw from the simulation's generator
+random_generator particle_random = [] {
+    random_generator generator;
+    seed_random(generator, 0x9a271c1e5u);
+    return generator;
+}();
+
+void init_particle_system(particle_system& system, const size_t capacity)
+{
+    system.pos_x.assign(capacity, 0.0f);
+    system.pos_y.assign(capacity, 0.0f);
+    system.vel_x.assign(capacity, 0.0f);
+    system.vel_y.assign(capacity, 0.0f);
+    system.life.assign(capacity, 0.0f);
+    system.fade_rate.assign(capacity, 0.0f);
+    system.size.assign(capacity, 0.0f);
+    system.color.assign(capacity, BLANK);
+    system.count = 0;
+}
+
+void clear_particles(particle_system& system)
+{
+    system.count = 0;
+}
+
+bool emit_particle(particle_system& system, const Vector2 pos, const Vector2 vel, const float life, const float fade_time, const float size, const Color color)
+{
+    if (system.count == system.capacity()) {
+        return false;
+    }
+
+    const size_t i = system.count++;
+    system.pos_x[i] = pos.x;
+    system.pos_y[i] = pos.y;
+    system.vel_x[i] = vel.x;
+    system.vel_y[i] = vel.y;
+    system.life[i] = life;
+    system.fade_rate[i] = fade_time > 0.0f ? 1.0f / fade_time : INFINITY;
+    system.size[i] = size;
+    system.color[i] = color;
+
+    return true;
+}
+
+bool emit_particles(particle_system& system, const Vector2 pos, const particle_burst& burst)
+{
+    constexpr float radians_per_degree = std::numbers::pi_v<float> / 180.0f;
+
+    for (size_t i = 0; i < burst.count; ++i) {
+        const float angle = random_float(particle_random, burst.min_angle, burst.max_angle) * radians_per_degree;
+        const float speed = random_float(particle_random, burst.min_speed, burst.max_speed);
+        const float life = random_float(particle_random, burst.min_life, burst.max_life);
+        // Screen y grows downwards, so counterclockwise angles go up
+        const Vector2 vel = { std::cos(angle) * speed, -std::sin(angle) * speed };
+        if (!emit_particle(system, pos, vel, life, burst.fade_time, burst.size, burst.color)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Advances particles [begin, end) and returns whether any of them expired. Positions leaving the
+// bounds of a bouncing system are clamped back in and the velocity along that axis is reversed,
+// exactly as the SSE2 kernel does.
+template <bool bounce>
+bool update_particle_range(particle_system& system, const float elapsed, const size_t begin, const size_t end)
+{
+    const float gravity = system.gravity * elapsed;
+    const float min_x = system.bounds.x;
+    const float max_x = system.bounds.x + system.bounds.width;
+    const float min_y = system.bounds.y;
+    const float max_y = system.bounds.y + system.bounds.height;
+
+    bool expired = false;
+    for (size_t i = begin; i < end; ++i) {
+        float vel_x = system.vel_x[i];
+        float vel_y = system.vel_y[i] + gravity;
+        float pos_x = system.pos_x[i] + vel_x * elapsed;
+        float pos_y = system.pos_y[i] + vel_y * elapsed;
+        if constexpr (bounce) {
+            if (pos_x < min_x || pos_x > max_x) {
+                vel_x = -vel_x;
+                pos_x = std::min(std::max(pos_x, min_x), max_x);
+            }
+            if (pos_y < min_y || pos_y > max_y) {
+                vel_y = -vel_y;
+                pos_y = std::min(std::max(pos_y, min_y), max_y);
+            }
+        }
+        system.pos_x[i] = pos_x;
+        system.pos_y[i] = pos_y;
+        system.vel_x[i] = vel_x;
+        system.vel_y[i] = vel_y;
+        system.life[i] -= elapsed;
+        expired |= system.life[i] <= 0.0f;
+    }
+
+    return expired;
+}
+
+#ifdef PARTICLES_SSE2
+// Four particles per iteration; returns where the scalar tail has to pick up
+template <bool bounce>
+size_t update_particles_sse2(particle_system& system, const float elapsed, bool& expired)
+{
+    const __m128 dt = _mm_set1_ps(elapsed);
+    const __m128 gravity = _mm_set1_ps(system.gravity * elapsed);
+    const __m128 min_x = _mm_set1_ps(system.bounds.x);
+    const __m128 max_x = _mm_set1_ps(system.bounds.x + system.bounds.width);
+    const __m128 min_y = _mm_set1_ps(system.bounds.y);
+    const __m128 max_y = _mm_set1_ps(system.bounds.y + system.bounds.height);
+    const __m128 sign_bit = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 any_expired = zero;
+
+    float* const pos_x = system.pos_x.data();
+    float* const pos_y = system.pos_y.data();
+    float* const vel_x = system.vel_x.data();
+    float* const vel_y = system.vel_y.data();
+    float* const life = system.life.data();
+
+    size_t i = 0;
+    for (; i + 4 <= system.count; i += 4) {
+        __m128 vx = _mm_loadu_ps(vel_x + i);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(vel_y + i), gravity);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(pos_x + i), _mm_mul_ps(vx, dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(pos_y + i), _mm_mul_ps(vy, dt));
+        if constexpr (bounce) {
+            // Flip the sign of the velocity in the lanes that left the bounds
+            const __m128 out_x = _mm_or_ps(_mm_cmplt_ps(x, min_x), _mm_cmpgt_ps(x, max_x));
+            const __m128 out_y = _mm_or_ps(_mm_cmplt_ps(y, min_y), _mm_cmpgt_ps(y, max_y));
+            vx = _mm_xor_ps(vx, _mm_and_ps(out_x, sign_bit));
+            vy = _mm_xor_ps(vy, _mm_and_ps(out_y, sign_bit));
+            x = _mm_min_ps(_mm_max_ps(x, min_x), max_x);
+            y = _mm_min_ps(_mm_max_ps(y, min_y), max_y);
+        }
+        _mm_storeu_ps(pos_x + i, x);
+        _mm_storeu_ps(pos_y + i, y);
+        _mm_storeu_ps(vel_x + i, vx);
+        _mm_storeu_ps(vel_y + i, vy);
+        const __m128 life_left = _mm_sub_ps(_mm_loadu_ps(life + i), dt);
+        _mm_storeu_ps(life + i, life_left);
+        any_expired = _mm_or_ps(any_expired, _mm_cmple_ps(life_left, zero));
+    }
+
+    expired = _mm_movemask_ps(any_expired) != 0;
+    return i;
+}
+#endif
+
+// Swap-remove: the last particle takes the place of the removed one
+void remove_dead_particles(particle_system& system)
+{
+    size_t i = 0;
+    while (i < system.count) {
+        if (system.life[i] > 0.0f) {
+            ++i;
+            continue;
+        }
+        const size_t last = --system.count;
+        system.pos_x[i] = system.pos_x[last];
+        system.pos_y[i] = system.pos_y[last];
+        system.vel_x[i] = system.vel_x[last];
+        system.vel_y[i] = system.vel_y[last];
+        system.life[i] = system.life[last];
+        system.fade_rate[i] = system.fade_rate[last];
+        system.size[i] = system.size[last];
+        system.color[i] = system.color[last];
+    }
+}
+
+void update_particles(particle_system& system, const float elapsed)
+{
+    PROFILE_ZONE("update_particles");
+
+#ifdef PARTICLES_SSE2
+    bool expired = false;
+    if (system.bounce) {
+        const size_t tail = update_particles_sse2<true>(system, elapsed, expired);
+        expired |= update_particle_range<true>(system, elapsed, tail, system.count);
+    } else {
+        const size_t tail = update_particles_sse2<false>(system, elapsed, expired);
+        expired |= update_particle_range<false>(system, elapsed, tail, system.count);
+    }
+    if (expired) {
+        remove_dead_particles(system);
+    }
+#else
+    update_particles_scalar(system, elapsed);
+#endif
+}
+
+void update_particles_scalar(particle_system& system, const float elapsed)
+{
+    const bool expired = system.bounce
+        ? update_particle_range<true>(system, elapsed, 0, system.count)
+        : update_particle_range<false>(system, elapsed, 0, system.count);
+    if (expired) {
+        remove_dead_particles(system);
+    }
+}
+
+const char* get_particle_kernel_name()
+{
+#ifdef PARTICLES_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void draw_particles(const particle_system& system, const Vector2 offset)
+{
+    PROFILE_ZONE("draw_particles");
+
+    if (system.count == 0) {
+        return;
+    }
+
+    rlSetTexture(rlGetTextureIdDefault());
+    for (size_t begin = 0; begin < system.count; begin += particle_draw_run) {
+        const size_t end = std::min(begin + particle_draw_run, system.count);
+        // Flushes the batch first if the run would not fit in it
+        if (rlCheckRenderBatchLimit(static_cast<int>(4 * (end - begin)))) {
+            ++frame_draw_stats.batch_flushes;
+        }
+
+        rlBegin(RL_QUADS);
+        for (size_t i = begin; i < end; ++i) {
+            const Color color = system.color[i];
+            const float opacity = std::min(system.life[i] * system.fade_rate[i], 1.0f);
+            const float half_size = system.size[i] * 0.5f;
+            const float x = system.pos_x[i] + offset.x;
+            const float y = system.pos_y[i] + offset.y;
+
+            rlColor4ub(color.r, color.g, color.b, static_cast<unsigned char>(static_cast<float>(color.a) * opacity));
+            rlTexCoord2f(0.0f, 0.0f);
+            rlVertex2f(x - half_size, y - half_size);
+            rlTexCoord2f(0.0f, 1.0f);
+            rlVertex2f(x - half_size, y + half_size);
+            rlTexCoord2f(1.0f, 1.0f);
+            rlVertex2f(x + half_size, y + half_size);
+            rlTexCoord2f(1.0f, 0.0f);
+            rlVertex2f(x + half_size, y - half_size);
+        }
+        rlEnd();
+    }
+    rlSetTexture(0);
+
+    ++frame_draw_stats.draw_calls;
+    frame_draw_stats.quads += system.count;
+}
@@ -0,0 +1,62 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <vector>
+
+// Cosmetic particles: block debris, paddle sparks, victory fireworks. They live in screen space,
+// never feed back into the simulation and draw their randomness from a generator of their own.
+
+inline constexpr size_t default_particle_capacity = size_t { 1 } << 17;
+
+// Stored as structure-of-arrays so the update kernel moves four particles per SSE2 instruction.
+// Live particles are packed at the front; particles whose life runs out are swap-removed.
+struct particle_system {
+    float gravity = 0.0f; // Pixels per second squared, downwards
+    bool bounce = false; // Reflect off the edges of bounds instead of leaving them
+    Rectangle bounds = {};
+
+    std::vector<float> pos_x, pos_y;
+    std::vector<float> vel_x, vel_y;
+    std::vector<float> life; // Seconds left
+    std::vector<float> fade_rate; // Opacity is life * fade_rate, capped at 1
+    std::vector<float> size;
+    std::vector<Color> color;
+    size_t count = 0;
+
+    size_t capacity() const { return pos_x.size(); }
+};
+
+// A burst of particles flying out of one point in random directions within an arc
+struct particle_burst {
+    size_t count;
+    float min_angle, max_angle; // Degrees, counterclockwise from the right on screen
+    float min_speed, max_speed; // Pixels per second
+    float min_life, max_life; // Seconds
+    float fade_time; // The particles fade out over their last fade_time seconds
+    float size; // Pixels
+    Color color;
+};
+
+// Allocates every particle up front; emitting past capacity drops the extra particles
+void init_particle_system(particle_system& system, size_t capacity = default_particle_capacity);
+void clear_particles(particle_system& system);
+
+// Returns false if the system was too full for some of the particles
+bool emit_particle(particle_system& system, Vector2 pos, Vector2 vel, float life, float fade_time, float size, Color color);
+bool emit_particles(particle_system& system, Vector2 pos, const particle_burst& burst);
+
+// Moves every particle on by elapsed seconds and removes the ones whose life ran out
+void update_particles(particle_system& system, float elapsed);
+// The same without SIMD, for comparison in benchmarks
+void update_particles_scalar(particle_system& system, float elapsed);
+// "sse2" or "scalar", whichever update_particles() uses in this build
+const char* get_particle_kernel_name();
+
+// One untextured quad per particle, fed to rlgl in runs that fit its batch. offset is added to
+// every position, for particles that move with a scrolling view.
+void draw_particles(const particle_system& system, Vector2 offset = { 0.0f, 0.0f });
+
+#endif // PARTICLES_H
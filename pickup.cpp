@@ -0,0 +1,58 @@
+#include "pickup.h"
+#include "paddle.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "world.h"
+
+#include "raylib.h"
+
+bool spawn_pickup(pickup_pool& pickups, const Vector2 pos, const pickup_kind kind)
+{
+    if (pickups.count == max_pickups) {
+        return false;
+    }
+    pickups.pos[pickups.count] = pos;
+    pickups.kind[pickups.count] = kind;
+    ++pickups.count;
+
+    return true;
+}
+
+// Swap-remove: the last pickup takes the place of the removed one
+void despawn_pickup(pickup_pool& pickups, const size_t index)
+{
+    const size_t last = pickups.count - 1;
+    pickups.pos[index] = pickups.pos[last];
+    pickups.kind[index] = pickups.kind[last];
+    --pickups.count;
+}
+
+void clear_pickups(pickup_pool& pickups)
+{
+    pickups.count = 0;
+}
+
+void move_pickups(game_world& world)
+{
+    PROFILE_ZONE("move_pickups");
+
+    pickup_pool& pickups = world.pickups;
+    const Rectangle paddle_rec = { world.paddle_pos.x, world.paddle_pos.y, paddle_size.x, paddle_size.y };
+    const float level_bottom = static_cast<float>(world.level.rows);
+
+    size_t i = 0;
+    while (i < pickups.count) {
+        Vector2& pos = pickups.pos[i];
+        pos.y += pickup_properties_table[pickups.kind[i]].fall_speed * tick_duration;
+
+        if (CheckCollisionRecs({ pos.x, pos.y, pickup_size.x, pickup_size.y }, paddle_rec)) {
+            // TODO: Apply the speed boost, for now a pickup only counts as collected
+            emit_game_event(world, powerup_collected_event, pos);
+            despawn_pickup(pickups, i);
+        } else if (pos.y > level_bottom) {
+            despawn_pickup(pickups, i);
+        } else {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PICKUP_H
+#define PICKUP_H
+
+#include "raylib.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct game_world;
+
+// Things that fall out of broken blocks for the paddle to catch
+enum pickup_kind : uint8_t {
+    speed_pickup,
+    pickup_kind_count
+};
+
+struct pickup_properties {
+    float fall_speed; // Cells per second
+    const char* label;
+    Color tint;
+};
+
+inline constexpr pickup_properties pickup_properties_table[pickup_kind_count] = {
+    /* speed_pickup */ { 3.0f, "S", YELLOW },
+};
+
+inline constexpr Vector2 pickup_size = { 1.0f, 1.0f };
+
+// Spawns past this many pickups in flight are dropped, so the pool never allocates during play
+inline constexpr size_t max_pickups = 256;
+
+// Pickups in flight, packed at the front of fixed arrays: pickup i is live for i < count.
+// Despawning moves the last pickup into the gap, so the order is not stable.
+struct pickup_pool {
+    std::array<Vector2, max_pickups> pos;
+    std::array<pickup_kind, max_pickups> kind;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+// Returns false when the pool is full
+bool spawn_pickup(pickup_pool& pickups, Vector2 pos, pickup_kind kind);
+void despawn_pickup(pickup_pool& pickups, size_t index);
+void clear_pickups(pickup_pool& pickups);
+
+// Moves every pickup down one tick, collecting those that touch the paddle and dropping those
+// that fall out of the level
+void move_pickups(game_world& world);
+
+#endif // PICKUP_H
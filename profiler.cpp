@@ -0,0 +1,171 @@
+#include "profiler.h"
+
+#ifdef BREAKOUT_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+struct profile_ring {
+    uint32_t thread_id = 0;
+    uint32_t depth = 0;
+    std::unique_ptr<profile_sample[]> samples = std::make_unique<profile_sample[]>(profile_ring_capacity);
+    std::atomic<uint64_t> written { 0 }; // Total ever written; the newest sample is at (written - 1) % capacity
+};
+
+// Rings are never freed, so a thread's zones can still be dumped after it has exited
+std::mutex profile_rings_mutex;
+std::vector<std::unique_ptr<profile_ring>> profile_rings;
+thread_local profile_ring* current_profile_ring = nullptr;
+
+const auto profile_epoch = std::chrono::steady_clock::now();
+
+// Frame boundaries, written and read by the main thread only
+int64_t profile_frame_ends[profile_frame_capacity];
+size_t profile_frames_written = 0;
+int64_t profile_frame_start = 0;
+
+profile_ring& get_profile_ring()
+{
+    if (current_profile_ring == nullptr) {
+        const std::lock_guard lock(profile_rings_mutex);
+        profile_rings.push_back(std::make_unique<profile_ring>());
+        current_profile_ring = profile_rings.back().get();
+        current_profile_ring->thread_id = static_cast<uint32_t>(profile_rings.size());
+    }
+    return *current_profile_ring;
+}
+
+void record_profile_sample(profile_ring& ring, const profile_sample& sample)
+{
+    const uint64_t index = ring.written.load(std::memory_order_relaxed);
+    ring.samples[index % profile_ring_capacity] = sample;
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+int64_t profile_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profile_epoch).count();
+}
+
+profile_scope::profile_scope(const char* name)
+    : name(name)
+{
+    ++get_profile_ring().depth;
+    start_ns = profile_now();
+}
+
+profile_scope::~profile_scope()
+{
+    const int64_t end_ns = profile_now();
+    profile_ring& ring = get_profile_ring();
+    --ring.depth;
+    record_profile_sample(ring, { name, start_ns, end_ns, ring.depth });
+}
+
+void profile_end_frame()
+{
+    const int64_t now = profile_now();
+    record_profile_sample(get_profile_ring(), { "frame", profile_frame_start, now, 0 });
+
+    profile_frame_ends[profile_frames_written % profile_frame_capacity] = now;
+    ++profile_frames_written;
+    profile_frame_start = now;
+}
+
+// Start of the window covering the last frame_count frames
+int64_t get_profile_window_start(const size_t frame_count)
+{
+    const size_t available = std::min(profile_frames_written, profile_frame_capacity);
+    if (frame_count == 0 || available == 0) {
+        return profile_frame_start;
+    }
+    if (frame_count >= available) {
+        // The oldest frame kept started where the one before it ended, which is gone
+        return available < profile_frames_written ? profile_frame_ends[profile_frames_written % profile_frame_capacity] : 0;
+    }
+    return profile_frame_ends[(profile_frames_written - frame_count - 1) % profile_frame_capacity];
+}
+
+// Calls visit for every sample that ended after window_start, on every thread
+template <typename Visit>
+void visit_profile_samples(const int64_t window_start, Visit&& visit)
+{
+    const std::lock_guard lock(profile_rings_mutex);
+    for (const auto& ring : profile_rings) {
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+        // The oldest slots may be overwritten while we read them, so leave some slack
+        const uint64_t slack = profile_ring_capacity / 16;
+        const uint64_t first = written > profile_ring_capacity - slack ? written - (profile_ring_capacity - slack) : 0;
+        for (uint64_t i = first; i < written; ++i) {
+            const profile_sample& sample = ring->samples[i % profile_ring_capacity];
+            if (sample.end_ns >= window_start) {
+                visit(*ring, sample);
+            }
+        }
+    }
+}
+
+std::vector<float> get_profile_frame_times()
+{
+    std::vector<float> result;
+    const size_t available = std::min(profile_frames_written, profile_frame_capacity);
+    for (size_t i = profile_frames_written - available + 1; i < profile_frames_written; ++i) {
+        const int64_t duration = profile_frame_ends[i % profile_frame_capacity] - profile_frame_ends[(i - 1) % profile_frame_capacity];
+        result.push_back(static_cast<float>(duration) / 1e6f);
+    }
+    return result;
+}
+
+std::vector<profile_zone_total> get_profile_zone_totals(const size_t frame_count)
+{
+    const int64_t window_start = get_profile_window_start(frame_count);
+    const int64_t window_end = profile_frame_start;
+
+    std::vector<profile_zone_total> totals;
+    visit_profile_samples(window_start, [&](const profile_ring&, const profile_sample& sample) {
+        if (sample.end_ns > window_end || std::strcmp(sample.name, "frame") == 0) {
+            return;
+        }
+        // Identical literals in different translation units may not share an address
+        auto total = std::find_if(totals.begin(), totals.end(), [&](const profile_zone_total& t) { return std::strcmp(t.name, sample.name) == 0; });
+        if (total == totals.end()) {
+            totals.push_back({ sample.name, 0.0, 0 });
+            total = totals.end() - 1;
+        }
+        total->milliseconds += static_cast<double>(sample.end_ns - sample.start_ns) / 1e6;
+        ++total->calls;
+    });
+
+    std::sort(totals.begin(), totals.end(), [](const profile_zone_total& a, const profile_zone_total& b) { return a.milliseconds > b.milliseconds; });
+    return totals;
+}
+
+bool write_profile_trace(const char* path, const size_t frame_count)
+{
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const int64_t window_start = get_profile_window_start(frame_count);
+
+    // Complete ("X") events with microsecond timestamps
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    visit_profile_samples(window_start, [&](const profile_ring& ring, const profile_sample& sample) {
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            first ? "" : ",\n", sample.name, ring.thread_id,
+            static_cast<double>(sample.start_ns) / 1e3, static_cast<double>(sample.end_ns - sample.start_ns) / 1e3);
+        first = false;
+    });
+    std::fprintf(file, "\n]}\n");
+
+    return std::fclose(file) == 0;
+}
+
+#endif // BREAKOUT_PROFILER
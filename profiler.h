@@ -0,0 +1,74 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Scoped-zone frame profiler. Configure with -DBREAKOUT_PROFILER=ON to enable it; otherwise
+// PROFILE_ZONE() and PROFILE_FRAME() expand to nothing and none of this is compiled.
+//
+//   void move_balls()
+//   {
+//       PROFILE_ZONE("move_balls");
+//       ...
+//   }
+//
+// Every thread writes its zones to its own ring buffer, so recording takes no lock.
+
+#ifdef BREAKOUT_PROFILER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+inline constexpr size_t profile_ring_capacity = size_t { 1 } << 16; // Zones per thread
+inline constexpr size_t profile_frame_capacity = 600;
+
+struct profile_sample {
+    const char* name; // Must outlive the profiler, in practice a string literal
+    int64_t start_ns;
+    int64_t end_ns;
+    uint32_t depth;
+};
+
+struct profile_scope {
+    explicit profile_scope(const char* name);
+    ~profile_scope();
+
+    profile_scope(const profile_scope&) = delete;
+    profile_scope& operator=(const profile_scope&) = delete;
+
+    const char* name;
+    int64_t start_ns;
+};
+
+struct profile_zone_total {
+    const char* name;
+    double milliseconds;
+    size_t calls;
+};
+
+// Nanoseconds on the steady clock since the profiler started
+int64_t profile_now();
+
+// Closes the current frame; call once per frame after the buffers are swapped
+void profile_end_frame();
+
+// Durations of the most recent frames in milliseconds, oldest first
+std::vector<float> get_profile_frame_times();
+// Time spent per zone over the last frame_count frames on every thread, largest first
+std::vector<profile_zone_total> get_profile_zone_totals(size_t frame_count);
+// Writes the zones of the last frame_count frames as a Chrome trace_event JSON file, which
+// chrome://tracing and Perfetto open
+bool write_profile_trace(const char* path, size_t frame_count);
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) const profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FRAME() profile_end_frame()
+
+#else
+
+#define PROFILE_ZONE(name) static_cast<void>(0)
+#define PROFILE_FRAME() static_cast<void>(0)
+
+#endif // BREAKOUT_PROFILER
+
+#endif // PROFILER_H
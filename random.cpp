@@ -0,0 +1,41 @@
+#include "random.h"
+
+void seed_random(random_generator& generator, const uint64_t seed)
+{
+    generator.state = 0;
+    generator.increment = (seed << 1u) | 1u;
+    next_random(generator);
+    generator.state += seed;
+    next_random(generator);
+}
+
+uint32_t next_random(random_generator& generator)
+{
+    const uint64_t old_state = generator.state;
+    generator.state = old_state * 6364136223846793005ull + generator.increment;
+
+    const auto xor_shifted = static_cast<uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+    const auto rotation = static_cast<uint32_t>(old_state >> 59u);
+    return (xor_shifted >> rotation) | (xor_shifted << ((-rotation) & 31u));
+}
+
+int random_int(random_generator& generator, const int min, const int max)
+{
+    const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+
+    // Reject the top partial bucket so every value is equally likely
+    const uint64_t limit = (uint64_t { 1 } << 32) - (uint64_t { 1 } << 32) % range;
+    uint64_t value = next_random(generator);
+    while (value >= limit) {
+        value = next_random(generator);
+    }
+
+    return static_cast<int>(min + static_cast<int64_t>(value % range));
+}
+
+float random_float(random_generator& generator, const float min, const float max)
+{
+    // The top 24 bits fill a float's mantissa exactly
+    const float unit = static_cast<float>(next_random(generator) >> 8u) * (1.0f / 16777216.0f);
+    return min + (max - min) * unit;
+}
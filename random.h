@@ -0,0 +1,21 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// PCG32 (XSH RR): small state, fast, and identical on every platform. Every game world has a
+// generator of its own (see world.h); effects and tools that must not disturb a game's
+// randomness keep theirs.
+struct random_generator {
+    uint64_t state = 0;
+    uint64_t increment = 1;
+};
+
+void seed_random(random_generator& generator, uint64_t seed);
+uint32_t next_random(random_generator& generator);
+// Uniform in [min, max], both inclusive
+int random_int(random_generator& generator, int min, int max);
+// Uniform in [min, max)
+float random_float(random_generator& generator, float min, float max);
+
+#endif // RANDOM_H
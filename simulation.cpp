@@ -0,0 +1,156 @@
+#include "simulation.h"
+
+#include "ball.h"
+#include "game.h"
+#include "level.h"
+#include "paddle.h"
+#include "pickup.h"
+#include "profiler.h"
+#include "random.h"
+#include "snapshot.h"
+#include "world.h"
+
+#include "raylib.h"
+
+#include <vector>
+
+void set_tick_rate(const float rate)
+{
+    tick_rate = rate;
+    tick_duration = 1.0f / rate;
+}
+
+void emit_game_event(game_world& world, const game_event_type type, const Vector2 pos)
+{
+    world.events.push_back({ type, pos });
+}
+
+void seed_world(game_world& world, const uint64_t seed)
+{
+    world.seed = seed;
+    seed_random(world.random, seed);
+}
+
+void simulate_tick(game_world& world, const input_state& input)
+{
+    PROFILE_ZONE("simulate_tick");
+
+    world.events.clear();
+
+    world.paddle_prev_pos = world.paddle_pos;
+
+    if (input.toggle_pause && world.state == in_game_state) {
+        world.state = paused_state;
+    } else if (input.toggle_pause && world.state == paused_state) {
+        world.state = in_game_state;
+    }
+
+    if (world.state == paused_state) {
+        // move_balls() only keeps the previous positions on the ticks the balls move in
+        hold_balls(world.balls);
+        return;
+    }
+
+    if (world.state == game_over_state) {
+        if (input.confirm) {
+            // Restart the level from the snapshot load_level() took
+            restart_level(world);
+            world.state = in_game_state;
+        } else if (input.back_to_menu) {
+            // Return to Menu
+            world.level_index = 0;
+            world.state = menu_state;
+        }
+        return;
+    }
+
+    if (world.state == victory_state) {
+        if (input.confirm) {
+            world.state = menu_state;
+        }
+        return;
+    }
+
+    if (world.state == menu_state) {
+        if (input.confirm) {
+            world.state = in_game_state;
+            load_level(world, 0); // Start/Reset Level 1
+        } else if (input.selected_level >= 0 && input.selected_level < static_cast<int>(get_level_count())) {
+            world.state = in_game_state;
+            world.level_index = input.selected_level;
+            load_level(world, 0);
+        }
+        return;
+    }
+
+    // In Game Logic
+    if (input.move_left) {
+        move_paddle(world, -paddle_speed * tick_duration);
+    }
+    if (input.move_right) {
+        move_paddle(world, paddle_speed * tick_duration);
+    }
+    move_balls(world);
+    move_pickups(world);
+
+    // Level Transition Logic
+    if (world.balls.empty()) {
+        emit_game_event(world, ball_lost_event);
+        world.state = game_over_state;
+    } else if (world.level_blocks == 0) {
+        emit_game_event(world, level_cleared_event);
+        load_level(world, 1);
+    }
+}
+
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+uint64_t hash_bytes(uint64_t hash, const void* data, const size_t size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * fnv_prime;
+    }
+    return hash;
+}
+
+template <typename T>
+uint64_t hash_value(const uint64_t hash, const T& value)
+{
+    return hash_bytes(hash, &value, sizeof(value));
+}
+
+template <typename T>
+uint64_t hash_vector(const uint64_t hash, const std::vector<T>& values)
+{
+    return hash_bytes(hash_value(hash, values.size()), values.data(), values.size() * sizeof(T));
+}
+
+uint64_t hash_game_state(const game_world& world)
+{
+    uint64_t hash = fnv_offset_basis;
+    hash = hash_value(hash, world.state);
+    hash = hash_value(hash, world.level_index);
+    hash = hash_value(hash, world.level_blocks);
+    hash = hash_value(hash, world.level.rows);
+    hash = hash_value(hash, world.level.columns);
+    if (!world.level.cells.empty()) {
+        hash = hash_bytes(hash, world.level.cells.data(), world.level.rows * world.level.columns * sizeof(cell));
+    }
+
+    hash = hash_value(hash, world.paddle_pos);
+    hash = hash_vector(hash, world.balls.pos_x);
+    hash = hash_vector(hash, world.balls.pos_y);
+    hash = hash_vector(hash, world.balls.vel_x);
+    hash = hash_vector(hash, world.balls.vel_y);
+
+    hash = hash_value(hash, world.pickups.count);
+    hash = hash_bytes(hash, world.pickups.pos.data(), world.pickups.count * sizeof(Vector2));
+    hash = hash_bytes(hash, world.pickups.kind.data(), world.pickups.count * sizeof(pickup_kind));
+
+    hash = hash_value(hash, world.random.state);
+    hash = hash_value(hash, world.random.increment);
+
+    return hash;
+}
@@ -0,0 +1,60 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "raylib.h"
+
+#include <cstdint>
+
+struct game_world;
+
+// Everything the simulation needs to know about the player for one tick.
+// The frontend fills it from the keyboard, the headless runner from a policy.
+struct input_state {
+    bool move_left = false;
+    bool move_right = false;
+    bool toggle_pause = false;
+    bool confirm = false;
+    bool back_to_menu = false;
+    int selected_level = -1;
+};
+
+enum game_event_type {
+    level_loaded_event,
+    level_cleared_event,
+    game_completed_event,
+    ball_lost_event,
+    powerup_collected_event,
+    multi_hit_block_damaged_event,
+    unbreakable_block_hit_event,
+    block_destroyed_event, // pos is (column, row)
+    paddle_hit_event, // pos is the ball's
+    level_cell_changed_event // pos is (column, row)
+};
+
+struct game_event {
+    game_event_type type;
+    Vector2 pos = { 0.0f, 0.0f };
+};
+
+// The simulation advances in fixed steps of tick_duration seconds, independent of the frame rate.
+// All speeds are expressed in cells per second.
+inline constexpr float default_tick_rate = 120.0f;
+inline float tick_rate = default_tick_rate;
+inline float tick_duration = 1.0f / default_tick_rate;
+
+void set_tick_rate(float rate);
+
+// Adds to world.events, see world.h
+void emit_game_event(game_world& world, game_event_type type, Vector2 pos = { 0.0f, 0.0f });
+
+// Seeds the world's random generator. Seeding with the seed of a recorded session makes the
+// session reproducible, see input_log.h.
+void seed_world(game_world& world, uint64_t seed);
+
+void simulate_tick(game_world& world, const input_state& input);
+
+// FNV-1a over everything simulate_tick() reads or writes, the random generator included.
+// Two runs that hash the same after the same ticks have behaved identically.
+uint64_t hash_game_state(const game_world& world);
+
+#endif // SIMULATION_H
@@ -0,0 +1,203 @@
+#include "snapshot.h"
+
+#include "ball.h"
+#include "level.h"
+#include "pickup.h"
+#include "profiler.h"
+#include "simulation.h"
+#include "world.h"
+
+#include <algorithm>
+#include <cstring>
+
+size_t get_world_snapshot_size(const game_world& world)
+{
+    return sizeof(world_snapshot_header)
+        + world.level.cells.size() * sizeof(cell)
+        + world.balls.size() * 6 * sizeof(float)
+        + world.pickups.count * (sizeof(Vector2) + sizeof(pickup_kind));
+}
+
+std::byte* write_bytes(std::byte* out, const void* data, const size_t size)
+{
+    if (size != 0) {
+        std::memcpy(out, data, size);
+    }
+    return out + size;
+}
+
+const std::byte* read_bytes(const std::byte* in, void* data, const size_t size)
+{
+    if (size != 0) {
+        std::memcpy(data, in, size);
+    }
+    return in + size;
+}
+
+void save_world_snapshot(const game_world& world, std::byte* out)
+{
+    const world_snapshot_header header = {
+        world.state,
+        world.level_blocks,
+        world.level_index,
+        world.level.rows,
+        world.level.columns,
+        world.balls.size(),
+        world.pickups.count,
+        world.paddle_pos,
+        world.paddle_prev_pos,
+        world.random,
+        world.seed
+    };
+    out = write_bytes(out, &header, sizeof(header));
+    out = write_bytes(out, world.level.cells.data(), world.level.cells.size() * sizeof(cell));
+
+    const size_t ball_bytes = header.balls * sizeof(float);
+    out = write_bytes(out, world.balls.pos_x.data(), ball_bytes);
+    out = write_bytes(out, world.balls.pos_y.data(), ball_bytes);
+    out = write_bytes(out, world.balls.vel_x.data(), ball_bytes);
+    out = write_bytes(out, world.balls.vel_y.data(), ball_bytes);
+    out = write_bytes(out, world.balls.prev_pos_x.data(), ball_bytes);
+    out = write_bytes(out, world.balls.prev_pos_y.data(), ball_bytes);
+
+    out = write_bytes(out, world.pickups.pos.data(), header.pickups * sizeof(Vector2));
+    write_bytes(out, world.pickups.kind.data(), header.pickups * sizeof(pickup_kind));
+}
+
+void restore_world_snapshot(game_world& world, const std::byte* in)
+{
+    PROFILE_ZONE("restore_world_snapshot");
+
+    world_snapshot_header header;
+    in = read_bytes(in, &header, sizeof(header));
+
+    world.state = header.state;
+    world.level_blocks = header.level_blocks;
+    world.level_index = header.level_index;
+    world.paddle_pos = header.paddle_pos;
+    world.paddle_prev_pos = header.paddle_prev_pos;
+    world.random = header.random;
+    world.seed = header.seed;
+
+    world.level.rows = header.rows;
+    world.level.columns = header.columns;
+    world.level.cells.resize(header.rows * header.columns);
+    in = read_bytes(in, world.level.cells.data(), world.level.cells.size() * sizeof(cell));
+
+    const size_t ball_bytes = header.balls * sizeof(float);
+    for (std::vector<float>* values : { &world.balls.pos_x, &world.balls.pos_y, &world.balls.vel_x, &world.balls.vel_y, &world.balls.prev_pos_x, &world.balls.prev_pos_y }) {
+        values->resize(header.balls);
+        in = read_bytes(in, values->data(), ball_bytes);
+    }
+
+    world.pickups.count = std::min(header.pickups, max_pickups);
+    in = read_bytes(in, world.pickups.pos.data(), world.pickups.count * sizeof(Vector2));
+    read_bytes(in, world.pickups.kind.data(), world.pickups.count * sizeof(pickup_kind));
+
+    world.events.clear();
+}
+
+void save_world_snapshot(const game_world& world, world_snapshot& snapshot)
+{
+    snapshot.bytes.resize(get_world_snapshot_size(world));
+    save_world_snapshot(world, snapshot.bytes.data());
+}
+
+void restore_world_snapshot(game_world& world, const world_snapshot& snapshot)
+{
+    restore_world_snapshot(world, snapshot.bytes.data());
+}
+
+void restart_level(game_world& world)
+{
+    PROFILE_ZONE("restart_level");
+
+    if (world.level_start.empty()) {
+        load_level(world, 0);
+        return;
+    }
+
+    // The generator moves on, only the level goes back
+    const random_generator random = world.random;
+    restore_world_snapshot(world, world.level_start);
+    world.random = random;
+
+    if (!world.balls.empty()) {
+        const Vector2 pos = get_ball_pos(world.balls, 0);
+        clear_balls(world.balls);
+        launch_random_ball(world, pos);
+    }
+
+    emit_game_event(world, level_loaded_event);
+}
+
+void init_rewind_buffer(rewind_buffer& buffer, const float seconds, const size_t memory)
+{
+    buffer.arena.assign(memory, std::byte { 0 });
+    buffer.entries.assign(std::max<size_t>(1, static_cast<size_t>(seconds * tick_rate)), {});
+    clear_rewind_buffer(buffer);
+}
+
+void clear_rewind_buffer(rewind_buffer& buffer)
+{
+    buffer.first = 0;
+    buffer.count = 0;
+}
+
+void drop_oldest_rewind_entry(rewind_buffer& buffer)
+{
+    buffer.first = (buffer.first + 1) % buffer.entries.size();
+    --buffer.count;
+}
+
+void push_rewind_snapshot(rewind_buffer& buffer, const game_world& world)
+{
+    PROFILE_ZONE("push_rewind_snapshot");
+
+    const size_t size = get_world_snapshot_size(world);
+    if (buffer.entries.empty() || size > buffer.arena.size()) {
+        clear_rewind_buffer(buffer);
+        return;
+    }
+
+    if (buffer.count == buffer.entries.size()) {
+        drop_oldest_rewind_entry(buffer);
+    }
+
+    // Right after the newest entry, or back at the start when it does not fit before the end.
+    // The bytes between the newest entry and the end of the arena then hold the oldest entries,
+    // and they go along with the ones the new entry overwrites.
+    size_t head = 0;
+    if (buffer.count > 0) {
+        const rewind_entry& newest = buffer.entries[(buffer.first + buffer.count - 1) % buffer.entries.size()];
+        head = newest.offset + newest.size;
+    }
+    const size_t offset = head + size <= buffer.arena.size() ? head : 0;
+    const size_t end = offset + size;
+    while (buffer.count > 0) {
+        const rewind_entry& oldest = buffer.entries[buffer.first];
+        const bool overwritten = oldest.offset < end && oldest.offset + oldest.size > offset;
+        const bool skipped = offset < head && oldest.offset >= head;
+        if (!overwritten && !skipped) {
+            break;
+        }
+        drop_oldest_rewind_entry(buffer);
+    }
+
+    save_world_snapshot(world, buffer.arena.data() + offset);
+    buffer.entries[(buffer.first + buffer.count) % buffer.entries.size()] = { offset, size };
+    ++buffer.count;
+}
+
+bool pop_rewind_snapshot(rewind_buffer& buffer, game_world& world)
+{
+    if (buffer.count == 0) {
+        return false;
+    }
+
+    const rewind_entry& newest = buffer.entries[(buffer.first + buffer.count - 1) % buffer.entries.size()];
+    restore_world_snapshot(world, buffer.arena.data() + newest.offset);
+    --buffer.count;
+
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "game.h"
+#include "random.h"
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+struct game_world;
+
+// A world packed into one run of bytes: everything simulate_tick() reads or writes (the state
+// hash_game_state() covers) plus the previous positions drawing interpolates from. The header
+// below comes first, followed by the grid cells, the six ball arrays and the live pickups, each
+// copied with a single memcpy. The bytes hold no pointers, so a snapshot can itself be copied
+// anywhere with memcpy. Events are not kept, they only describe the tick that emitted them.
+struct world_snapshot_header {
+    game_state state;
+    size_t level_blocks;
+    size_t level_index;
+    size_t rows;
+    size_t columns;
+    size_t balls;
+    size_t pickups;
+    Vector2 paddle_pos;
+    Vector2 paddle_prev_pos;
+    random_generator random;
+    uint64_t seed;
+};
+
+static_assert(std::is_trivially_copyable_v<world_snapshot_header>);
+static_assert(std::is_trivially_copyable_v<cell>);
+
+// Bytes save_world_snapshot() writes for the world as it is now
+size_t get_world_snapshot_size(const game_world& world);
+void save_world_snapshot(const game_world& world, std::byte* out);
+// The world's vectors keep their allocations, so restoring a world of the same size or smaller
+// allocates nothing
+void restore_world_snapshot(game_world& world, const std::byte* in);
+
+// One snapshot kept by itself; saving again reuses the allocation
+struct world_snapshot {
+    std::vector<std::byte> bytes;
+
+    bool empty() const { return bytes.empty(); }
+};
+
+void save_world_snapshot(const game_world& world, world_snapshot& snapshot);
+void restore_world_snapshot(game_world& world, const world_snapshot& snapshot);
+
+// Puts the current level back the way load_level() dealt it, from world.level_start, without
+// going back to the level source. The ball's launch direction is rolled again as on a load,
+// so restarts do not all play out the same.
+void restart_level(game_world& world);
+
+// The last ticks of a game, newest last, for stepping back through. Snapshots vary in size
+// with the grid, the balls and the pickups, so they are packed one after another into a fixed
+// arena and wrap around at its end; saving drops the oldest snapshots in the way. Memory stays
+// at the budget however large the world gets, and a larger world simply keeps fewer ticks.
+inline constexpr float default_rewind_seconds = 10.0f;
+inline constexpr size_t default_rewind_memory = size_t { 32 } << 20; // Bytes
+
+struct rewind_entry {
+    size_t offset;
+    size_t size;
+};
+
+struct rewind_buffer {
+    std::vector<std::byte> arena;
+    std::vector<rewind_entry> entries; // A ring of one entry per tick covered
+    size_t first = 0; // The oldest entry
+    size_t count = 0;
+
+    bool empty() const { return count == 0; }
+};
+
+// Sized for seconds at the current tick rate, so set the tick rate first
+void init_rewind_buffer(rewind_buffer& buffer, float seconds = default_rewind_seconds, size_t memory = default_rewind_memory);
+void clear_rewind_buffer(rewind_buffer& buffer);
+// Saves the world as the newest entry. A world larger than the whole arena cannot be kept and
+// empties the buffer instead, as the older entries could not be stepped back to past it anyway.
+// A buffer that was never initialized keeps nothing.
+void push_rewind_snapshot(rewind_buffer& buffer, const game_world& world);
+// Restores the newest entry and drops it; false when there is none
+bool pop_rewind_snapshot(rewind_buffer& buffer, game_world& world);
+
+#endif // SNAPSHOT_H
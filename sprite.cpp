@@ -1,41 +1,44 @@
 #include "sprite.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
-sprite load_sprite(
-    const std::string& file_name_prefix,
-    const std::string& file_name_suffix,
-    const size_t frame_count,
-    const bool loop,
-    const size_t frames_to_skip)
+void split_sprite_sheet(const Rectangle strip, const size_t frame_count, Rectangle* frames)
 {
-    assert(frame_count < 100);
+    assert(frame_count > 0);
 
-    const sprite result = { frame_count, frames_to_skip, 0, 0, loop, 0, new Texture2D[frame_count] };
+    const float frame_width = strip.width / static_cast<float>(frame_count);
     for (size_t i = 0; i < frame_count; ++i) {
-        std::string file_name;
-        if (frame_count < 10) {
-            file_name = file_name_prefix;
-            file_name += std::to_string(i);
-            file_name += file_name_suffix;
-        } else {
-            file_name = file_name_prefix;
-            file_name += i < 10 ? "0" + std::to_string(i) : std::to_string(i);
-            file_name += file_name_suffix;
-        }
-        result.frames[i] = LoadTexture(file_name.c_str());
+        frames[i] = { strip.x + frame_width * static_cast<float>(i), strip.y, frame_width, strip.height };
     }
+}
 
-    return result;
+void play_sprite(sprite& sprite, const sprite_animation& animation)
+{
+    sprite.animation = &animation;
+    sprite.time = 0.0f;
 }
 
-void unload_sprite(sprite& sprite)
+void advance_sprite(sprite& sprite, const float elapsed)
 {
-    assert(sprite.frames != nullptr);
+    assert(sprite.animation != nullptr);
 
-    for (size_t i = 0; i < sprite.frame_count; ++i) {
-        UnloadTexture(sprite.frames[i]);
+    sprite.time += elapsed;
+
+    // Keep looping time within one cycle so it never loses precision
+    const float cycle = sprite.animation->frame_duration * static_cast<float>(sprite.animation->frame_count);
+    if (sprite.animation->loop && cycle > 0.0f) {
+        sprite.time = std::fmod(sprite.time, cycle);
     }
-    delete[] sprite.frames;
-    sprite.frames = nullptr;
+}
+
+const Rectangle& get_sprite_frame(const sprite& sprite)
+{
+    assert(sprite.animation != nullptr && sprite.animation->frame_count > 0);
+
+    const sprite_animation& animation = *sprite.animation;
+    const auto frame = animation.frame_duration > 0.0f ? static_cast<size_t>(sprite.time / animation.frame_duration) : 0;
+
+    return animation.frames[animation.loop ? frame % animation.frame_count : std::min(frame, animation.frame_count - 1)];
 }
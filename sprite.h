@@ -3,19 +3,29 @@
 
 #include "raylib.h"
 
-#include <string>
+#include <cstddef>
 
-struct sprite {
+// An animation definition, shared by every sprite that plays it
+struct sprite_animation {
+    const Rectangle* frames = nullptr; // Regions of the texture atlas
     size_t frame_count = 0;
-    size_t frames_to_skip = 3;
-    size_t frames_skipped = 0;
-    size_t frame_index = 0;
+    float frame_duration = 0.1f; // Seconds
     bool loop = true;
-    size_t prev_game_frame = 0;
-    Texture2D* frames = nullptr;
 };
 
-sprite load_sprite(const std::string& file_name_prefix, const std::string& file_name_suffix, size_t frame_count = 1, bool loop = true, size_t frames_to_skip = 3);
-void unload_sprite(sprite& sprite);
+// The per-instance part: which animation and how far into it. Advancing and sampling are
+// both O(1), however many sprites are on screen.
+struct sprite {
+    const sprite_animation* animation = nullptr;
+    float time = 0.0f;
+};
+
+// Splits a sprite-sheet strip, frame_count equally wide frames left to right, into frame regions
+void split_sprite_sheet(Rectangle strip, size_t frame_count, Rectangle* frames);
+
+void play_sprite(sprite& sprite, const sprite_animation& animation);
+// elapsed is simulation time, so animations follow pauses and fast-forward like the game does
+void advance_sprite(sprite& sprite, float elapsed);
+const Rectangle& get_sprite_frame(const sprite& sprite);
 
 #endif // SPRITE_H
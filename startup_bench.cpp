@@ -0,0 +1,92 @@
+#include "assets.h"
+
+#include "raylib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+double milliseconds_since(const bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+double median(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Fonts and textures on the calling thread: decoding or mapping plus the uploads
+double time_graphics_assets()
+{
+    const auto start = bench_clock::now();
+    load_fonts();
+    load_textures();
+    const double result = milliseconds_since(start);
+
+    unload_textures();
+    unload_fonts();
+
+    return result;
+}
+
+// The way the game starts: everything on the workers, until the last upload is done
+double time_startup()
+{
+    const auto start = bench_clock::now();
+    begin_loading_assets();
+    update_asset_loading(true);
+    const double result = milliseconds_since(start);
+
+    unload_sounds();
+    unload_textures();
+    unload_fonts();
+
+    return result;
+}
+
+void run(const char* label, const int runs)
+{
+    std::vector<double> graphics;
+    std::vector<double> startup;
+    for (int i = 0; i < runs; ++i) {
+        graphics.push_back(time_graphics_assets());
+        startup.push_back(time_startup());
+    }
+    std::printf("%-8s fonts + textures %8.2f ms   fully loaded %8.2f ms   (median of %d)\n", label, median(graphics), median(startup), runs);
+}
+
+// Compares getting the assets ready from the loose files in data/ and from an asset archive.
+// Run it from the project root. The window stays hidden, it is only there for the uploads.
+int main(const int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s assets.pak [runs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const int runs = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "Breakout startup benchmark");
+
+    use_loose_assets();
+    run("loose", runs);
+
+    if (!use_asset_archive(argv[1])) {
+        std::fprintf(stderr, "cannot open %s\n", argv[1]);
+        CloseWindow();
+        return EXIT_FAILURE;
+    }
+    run("archive", runs);
+    use_loose_assets();
+
+    CloseWindow();
+
+    return EXIT_SUCCESS;
+}
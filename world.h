@@ -0,0 +1,44 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "ball.h"
+#include "game.h"
+#include "pickup.h"
+#include "random.h"
+#include "simulation.h"
+#include "snapshot.h"
+
+#include "raylib.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Everything one game in progress owns. The simulation functions take the world they act on
+// explicitly, so any number of games can run in one process, e.g. one per thread (see
+// analyze.cpp). The level sources (level.h) and the settings (tick rate, collision mode) are
+// shared by all worlds; pick them before the worlds start and leave them alone while they run.
+struct game_world {
+    game_state state = menu_state;
+
+    cell_grid level;
+    size_t level_blocks = 0; // Blocks left to destroy
+    size_t level_index = 0;
+    // The world right after load_level(), see restart_level()
+    world_snapshot level_start;
+
+    ball_set balls;
+    Vector2 paddle_pos = { 0.0f, 0.0f };
+    Vector2 paddle_prev_pos = { 0.0f, 0.0f };
+    pickup_pool pickups;
+
+    // The game's only source of randomness, see seed_world()
+    random_generator random;
+    uint64_t seed = 0;
+
+    // Emitted during the last call to simulate_tick() (or load_level()).
+    // Sound, graphics and statistics react to these instead of being called from the simulation.
+    std::vector<game_event> events;
+};
+
+#endif // WORLD_H